@@ -0,0 +1,287 @@
+#include "assembler.hpp"
+#include "parser.hpp"
+#include "pipeline.hpp"
+#include "codegen.hpp"
+#include "probes.hpp"
+#include <algorithm>
+#include <exception>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+using Defines = std::unordered_map<std::string, int32_t>;
+
+// Таблица символов перед раскладкой: импорт и константы --define
+static void resetSymbols(SymbolTable& symtab, const Assembler::Options& options, const Defines& defines) {
+    symtab.clear();
+    for (const auto* file : options.imports) symtab.import(*file);
+    for (const auto& [name, value] : defines) symtab.define(name, static_cast<uint16_t>(value));
+}
+
+// Кодогенерация по разложенной таблице и сбор результата; ошибки — исключениями
+static void generate(const Program& program, SymbolTable& symtab, const Assembler::Options& options,
+                     Assembler::Result& result, std::vector<uint16_t>& image) {
+    PDP11_PROBE1(phase_start, "generate");
+    CodeGenerator generator(symtab);
+    if (options.collectInstructions) {
+        generator.recordInstructions(&result.instructions);
+    }
+    if (options.collectLines) {
+        generator.recordLines(&result.lines);
+    }
+    if (options.collectFills) {
+        generator.recordFills(&result.fills);
+    }
+    if (options.pic) {
+        generator.recordRelocations(&result.relocations);
+    }
+    generator.setThreads(options.threads);
+    generator.generate(program, image);
+    PDP11_PROBE2(phase_end, "generate", image.size());
+
+    for (const auto& stmt : program.statements) {
+        const ASTNode* node = stmt.get();
+        if (auto label = dynamic_cast<const Label*>(node)) node = label->statement.get();
+        auto dir = dynamic_cast<const Directive*>(node);
+        if (dir && dir->type == Directive::Type::INCBIN &&
+            std::find(result.dependencies.begin(), result.dependencies.end(), dir->file) ==
+                result.dependencies.end()) {
+            result.dependencies.push_back(dir->file);
+        }
+    }
+
+    result.success = true;
+    result.words = image.size();
+    result.sections = symtab.sections().sections();
+}
+
+// Смещение метка(Rn) в --pic не становится относительным: предупреждение
+// на каждую такую команду (.WORD метка — обычные таблицы адресов, только в отчёте)
+static void warnRelocations(const Assembler::Result& result, std::vector<Diagnostic>& diagnostics) {
+    for (const auto& relocation : result.relocations) {
+        if (relocation.kind != Relocation::Kind::INDEX) continue;
+        diagnostics.push_back({Diagnostic::Severity::WARNING, {relocation.line, 1, 0},
+                               "Label used as index offset needs relocation in position-independent code"});
+    }
+}
+
+static void collectSymbols(const SymbolTable& symtab, Assembler::Result& result) {
+    result.symbols.reserve(symtab.symbols.size());
+    for (const auto& [name, sym] : symtab.symbols) {
+        result.symbols.push_back({name, sym.value, sym.is_constant});
+    }
+    std::sort(result.symbols.begin(), result.symbols.end(),
+              [](const Assembler::Symbol& a, const Assembler::Symbol& b) { return a.name < b.name; });
+}
+
+Assembler::Result Assembler::assemble(std::string_view source, const Options& options,
+                                      std::vector<uint16_t>& image) {
+    Result result;
+    image.clear();
+    diags.clear();
+
+    // С конвейером раскладка адресов идёт вместе с разбором; слиянию
+    // данных нужна вся программа до раскладки, поэтому с ним — последовательно
+    bool pipelined = options.pipeline && !options.dedupData;
+    std::unique_ptr<Program> program;
+    std::exception_ptr layoutError;
+    ConditionState conditions;
+    conditions.constants = options.defines;
+    if (pipelined) {
+        // Лексер, парсер и раскладка идут одновременно: одна фаза на всех
+        PDP11_PROBE1(phase_start, "pipeline");
+        resetSymbols(symtab, options, options.defines);
+        program = AssemblyPipeline().run(source, diags, symtab, layoutError, std::move(conditions),
+                                         options.allowIncbin);
+        PDP11_PROBE2(phase_end, "pipeline", program->statements.size());
+    } else {
+        PDP11_PROBE1(phase_start, "lex");
+        Lexer lexer(source);
+        lexer.setConditions(std::move(conditions));
+        lexer.tokenize(tokens);
+        PDP11_PROBE2(phase_end, "lex", tokens.size());
+        PDP11_PROBE1(phase_start, "parse");
+        Parser parser(tokens, lexer.lines(), diags);
+        parser.setIncbinAllowed(options.allowIncbin);
+        program = parser.parseProgram();
+        PDP11_PROBE2(phase_end, "parse", program->statements.size());
+    }
+
+    // Парсер копит все ошибки; с ошибками дальше не идём
+    if (diags.hasErrors()) {
+        result.diagnostics = diags.diagnostics();
+        return result;
+    }
+
+    try {
+        if (pipelined) {
+            if (layoutError) std::rethrow_exception(layoutError);
+            symtab.finish();
+        } else {
+            PDP11_PROBE1(phase_start, "layout");
+            resetSymbols(symtab, options, options.defines);
+            if (options.dedupData) {
+                result.dataStats = DataOptimizer(symtab).run(*program);
+            }
+            symtab.build(*program);
+            PDP11_PROBE2(phase_end, "layout", symtab.symbols.size());
+        }
+        generate(*program, symtab, options, result, image);
+    }
+    catch (const AssemblyError& e) {
+        image.clear();
+        diags.error(e.range, e.what());
+    }
+    catch (const std::exception& e) {
+        image.clear();
+        diags.error({}, e.what());
+    }
+
+    result.diagnostics = diags.diagnostics();
+    if (!result.success) return result;
+
+    warnRelocations(result, result.diagnostics);
+    if (options.collectSymbols) collectSymbols(symtab, result);
+    return result;
+}
+
+Assembler::Result Assembler::assemble(std::string_view source, const Options& options,
+                                      uint16_t* image, size_t capacity) {
+    Result result = assemble(source, options, scratch);
+    if (!result.success) return result;
+
+    if (result.words > capacity) {
+        result.success = false;
+        result.diagnostics.push_back({Diagnostic::Severity::ERROR, {},
+            "Output buffer too small: " + std::to_string(result.words) + " words required"});
+        return result;
+    }
+
+    std::memcpy(image, scratch.data(), result.words * sizeof(uint16_t));
+    return result;
+}
+
+// ========================================================
+// Варианты: общий разбор, раздельные раскладка и кодогенерация
+// ========================================================
+std::vector<Assembler::VariantResult> Assembler::assembleVariants(std::string_view source, const Options& options,
+                                                                  const std::vector<Variant>& variants) {
+    std::vector<VariantResult> results(variants.size());
+    std::vector<Defines> defines(variants.size(), options.defines);
+    for (size_t i = 0; i < variants.size(); i++) {
+        for (const auto& [name, value] : variants[i].defines) defines[i][name] = value;
+    }
+
+    // Разбор группы. base — таблица до раскладки (импорт и псевдонимы
+    // DataOptimizer), копируется в каждый вариант группы
+    struct FrontEnd {
+        size_t variant; // Первый вариант группы
+        std::unordered_set<std::string> consulted;
+        std::unique_ptr<Program> program;
+        std::vector<Diagnostic> diagnostics;
+        bool failed = false;
+        DataOptimizer::Stats dataStats;
+        SymbolTable base;
+    };
+    std::vector<FrontEnd> frontEnds;
+
+    // Тот же исход всех .IF: проверенные имена одинаково (не) определены
+    auto sameConditions = [&](const FrontEnd& frontEnd, const Defines& current) {
+        const Defines& first = defines[frontEnd.variant];
+        for (const auto& name : frontEnd.consulted) {
+            auto a = first.find(name);
+            auto b = current.find(name);
+            if ((a == first.end()) != (b == current.end())) return false;
+            if (a != first.end() && a->second != b->second) return false;
+        }
+        return true;
+    };
+
+    // 1. Лексер и парсер — последовательно, по разу на группу
+    for (size_t i = 0; i < variants.size(); i++) {
+        auto found = std::find_if(frontEnds.begin(), frontEnds.end(),
+                                  [&](const FrontEnd& frontEnd) { return sameConditions(frontEnd, defines[i]); });
+        if (found != frontEnds.end()) {
+            results[i].program = static_cast<size_t>(found - frontEnds.begin());
+            continue;
+        }
+
+        FrontEnd& frontEnd = frontEnds.emplace_back();
+        frontEnd.variant = i;
+        results[i].program = frontEnds.size() - 1;
+
+        diags.clear();
+        ConditionState conditions;
+        conditions.constants = defines[i];
+        PDP11_PROBE1(phase_start, "lex");
+        Lexer lexer(source);
+        lexer.setConditions(std::move(conditions));
+        lexer.tokenize(tokens);
+        PDP11_PROBE2(phase_end, "lex", tokens.size());
+        frontEnd.consulted = lexer.takeConditions().consulted;
+        PDP11_PROBE1(phase_start, "parse");
+        Parser parser(tokens, lexer.lines(), diags);
+        parser.setIncbinAllowed(options.allowIncbin);
+        frontEnd.program = parser.parseProgram();
+        PDP11_PROBE2(phase_end, "parse", frontEnd.program->statements.size());
+
+        frontEnd.failed = diags.hasErrors();
+        if (!frontEnd.failed) {
+            resetSymbols(frontEnd.base, options, {});
+            try {
+                if (options.dedupData) frontEnd.dataStats = DataOptimizer(frontEnd.base).run(*frontEnd.program);
+            }
+            catch (const std::exception& e) {
+                diags.error({}, e.what());
+                frontEnd.failed = true;
+            }
+        }
+        frontEnd.diagnostics = diags.diagnostics();
+    }
+
+    // 2. Раскладка и кодогенерация: потоки разбирают варианты по счётчику.
+    // Разделам каждого варианта достаётся доля ядер, а не все ядра
+    unsigned budget = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t threads = std::min<size_t>(variants.size(), budget);
+    Options variantOptions = options;
+    variantOptions.threads = static_cast<unsigned>(std::max<size_t>(1, budget / std::max<size_t>(1, threads)));
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1)) < variants.size();) {
+            const FrontEnd& frontEnd = frontEnds[results[i].program];
+            Result& result = results[i].result;
+            result.diagnostics = frontEnd.diagnostics;
+            if (frontEnd.failed) continue;
+            result.dataStats = frontEnd.dataStats;
+
+            SymbolTable table = frontEnd.base;
+            for (const auto& [name, value] : defines[i]) table.define(name, static_cast<uint16_t>(value));
+            try {
+                PDP11_PROBE1(phase_start, "layout");
+                table.build(*frontEnd.program);
+                PDP11_PROBE2(phase_end, "layout", table.symbols.size());
+                generate(*frontEnd.program, table, variantOptions, result, results[i].image);
+            }
+            catch (const AssemblyError& e) {
+                results[i].image.clear();
+                result.success = false;
+                result.diagnostics.push_back({Diagnostic::Severity::ERROR, e.range, e.what()});
+                continue;
+            }
+            catch (const std::exception& e) {
+                results[i].image.clear();
+                result.success = false;
+                result.diagnostics.push_back({Diagnostic::Severity::ERROR, {}, e.what()});
+                continue;
+            }
+            warnRelocations(result, result.diagnostics);
+            if (options.collectSymbols) collectSymbols(table, result);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+    return results;
+}
@@ -0,0 +1,96 @@
+#ifndef PDP11_ASSEMBLER_HPP
+#define PDP11_ASSEMBLER_HPP
+
+#include "lexer.hpp"
+#include "symtab.hpp"
+#include "codegen.hpp"
+#include "dataopt.hpp"
+#include "diagnostics.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// ========================================================
+// Встраиваемый ассемблер: текст в памяти -> образ в памяти.
+// Не работает с файлами (кроме .INCBIN, если не выключена в Options),
+// ничего не печатает и не бросает исключений наружу: все ошибки
+// возвращаются в diagnostics.
+// Экземпляр переиспользует внутренние буферы между вызовами.
+// ========================================================
+class Assembler {
+public:
+    struct Options {
+        bool collectSymbols = true;       // Заполнять Result::symbols
+        bool collectInstructions = false; // Заполнять Result::instructions
+        bool dedupData = false;           // Слияние и удаление блоков данных (DataOptimizer)
+        std::vector<const SymbolFile*> imports; // Внешние символы (--import-symbols)
+        bool pipeline = false;            // Лексер, парсер и раскладка в параллельных потоках
+        bool collectLines = false;        // Заполнять Result::lines
+        bool collectFills = false;        // Заполнять Result::fills
+        std::unordered_map<std::string, int32_t> defines; // Константы для .IF и кода (--define)
+        bool pic = false;                 // Позиционно-независимый код (--pic), Result::relocations
+        bool allowIncbin = true;          // false — .INCBIN даёт ошибку (запросы --serve)
+        unsigned threads = 0;             // Потоков на вызов (разделы, варианты); 0 — по числу ядер
+    };
+
+    // Вариант сборки (--variants): имя и определения поверх Options::defines
+    struct Variant {
+        std::string name;
+        std::unordered_map<std::string, int32_t> defines;
+    };
+
+    using Diagnostic = ::Diagnostic;
+
+    struct Symbol {
+        std::string name;
+        uint16_t value;
+        bool is_constant;
+    };
+
+    struct Result {
+        bool success = false;
+        size_t words = 0;       // Сколько слов образа записано (или требуется)
+        std::vector<Symbol> symbols;
+        std::vector<Diagnostic> diagnostics;
+        std::vector<EncodedInstruction> instructions; // По адресам, в порядке кодирования
+        DataOptimizer::Stats dataStats;               // При Options::dedupData
+        LineTable lines;                              // Адрес -> строка исходника
+        std::vector<std::string> dependencies;        // Файлы .INCBIN в порядке появления
+        std::vector<FillRun> fills;                   // Серии .FILL/.BLKB/.BLKW
+        std::vector<SectionLayout::Section> sections; // Разделы .PSECT (первый — безымянный)
+        std::vector<Relocation> relocations;          // При Options::pic: слова с адресами меток
+    };
+
+    struct VariantResult {
+        Result result;
+        std::vector<uint16_t> image;
+        size_t program = 0; // Номер разбора, общего для группы вариантов
+    };
+
+    // Образ пишется в вектор вызывающего (его ёмкость переиспользуется)
+    Result assemble(std::string_view source, const Options& options,
+                    std::vector<uint16_t>& image);
+
+    // Образ пишется в буфер фиксированного размера; если места мало,
+    // success == false, а words содержит требуемый размер
+    Result assemble(std::string_view source, const Options& options,
+                    uint16_t* image, size_t capacity);
+
+    // Много вариантов одного текста. Лексер и парсер работают один раз на
+    // группу вариантов, у которых совпадают значения имён, проверенных в .IF
+    // (остальные определения на токены не влияют). Раскладка и кодогенерация —
+    // по варианту в параллельных потоках над общей неизменяемой программой.
+    // Options::pipeline здесь не используется
+    std::vector<VariantResult> assembleVariants(std::string_view source, const Options& options,
+                                                const std::vector<Variant>& variants);
+
+private:
+    std::vector<Token> tokens;
+    std::vector<uint16_t> scratch;
+    DiagnosticEngine diags;
+    SymbolTable symtab;
+};
+
+#endif // PDP11_ASSEMBLER_HPP
@@ -110,16 +110,23 @@ std::unique_ptr<Instruction> createAdd(
     return instr;
 }
 
-std::unique_ptr<Instruction> createJsr(const std::string& target) {
+// JSR R,dst: регистр связи хранится в src
+std::unique_ptr<Instruction> createJsr(
+    std::unique_ptr<Operand> reg,
+    std::unique_ptr<Operand> dst)
+{
     auto instr = std::make_unique<Instruction>();
     instr->type = Instruction::Type::JSR;
-    instr->dst = createRel(target);
+    instr->src = std::move(reg);
+    instr->dst = std::move(dst);
     return instr;
 }
 
-std::unique_ptr<Instruction> createRts() {
+// RTS R: регистр хранится в dst
+std::unique_ptr<Instruction> createRts(std::unique_ptr<Operand> reg) {
     auto instr = std::make_unique<Instruction>();
     instr->type = Instruction::Type::RTS;
+    instr->dst = std::move(reg);
     return instr;
 }
 
@@ -141,10 +148,10 @@ std::unique_ptr<Instruction> createSub(
     return instr;
 }
 
-std::unique_ptr<Instruction> createJmp(const std::string& target) {
+std::unique_ptr<Instruction> createJmp(std::unique_ptr<Operand> dst) {
     auto instr = std::make_unique<Instruction>();
     instr->type = Instruction::Type::JMP;
-    instr->dst = createRel(target);
+    instr->dst = std::move(dst);
     return instr;
 }
 
@@ -186,26 +193,35 @@ std::unique_ptr<Instruction> createNeg(std::unique_ptr<Operand> dst) {
 std::unique_ptr<Directive> createWord(std::vector<std::unique_ptr<Operand>> values) {
     auto dir = std::make_unique<Directive>();
     dir->type = Directive::Type::WORD;
-    dir->operands = std::move(values);
+    dir->data.reserve(2 * values.size());
+    for (const auto& op : values) {
+        if (op->label.empty()) dir->appendWord(static_cast<uint16_t>(op->value));
+        else dir->appendFixup(op->label);
+    }
     return dir;
 }
 
 std::unique_ptr<Directive> createAscii(const std::string& text) {
     auto dir = std::make_unique<Directive>();
     dir->type = Directive::Type::ASCII;
-    
-    // Каждый символ - отдельный операнд
-    for (char c : text) {
-        dir->operands.push_back(createImm(static_cast<int>(c)));
-    }
-    
+    dir->data.assign(text.begin(), text.end());
+    return dir;
+}
+
+std::unique_ptr<Directive> createAsciz(const std::string& text) {
+    auto dir = createAscii(text);
+    dir->type = Directive::Type::ASCIZ;
+    dir->data.push_back(0);
     return dir;
 }
 
 std::unique_ptr<Directive> createByte(std::vector<std::unique_ptr<Operand>> values) {
     auto dir = std::make_unique<Directive>();
     dir->type = Directive::Type::BYTE;
-    dir->operands = std::move(values);
+    dir->data.reserve(values.size());
+    for (const auto& op : values) {
+        dir->data.push_back(static_cast<uint8_t>(op->value));
+    }
     return dir;
 }
 
@@ -226,8 +242,57 @@ std::unique_ptr<Directive> createEnd() {
 std::unique_ptr<Directive> createFill(int count, int value) {
     auto dir = std::make_unique<Directive>();
     dir->type = Directive::Type::FILL;
-    dir->operands.push_back(createImm(count));
-    dir->operands.push_back(createImm(value));
+    dir->fillBytes = 2 * static_cast<size_t>(count);
+    dir->fillPattern = static_cast<uint16_t>(value);
+    return dir;
+}
+
+std::unique_ptr<Directive> createBlkb(int count) {
+    auto dir = std::make_unique<Directive>();
+    dir->type = Directive::Type::BLKB;
+    dir->fillBytes = static_cast<size_t>(count);
+    return dir;
+}
+
+std::unique_ptr<Directive> createBlkw(int count) {
+    auto dir = std::make_unique<Directive>();
+    dir->type = Directive::Type::BLKW;
+    dir->fillBytes = 2 * static_cast<size_t>(count);
+    return dir;
+}
+
+std::unique_ptr<Directive> createIncbin(const std::string& file, size_t offset, size_t length) {
+    auto dir = std::make_unique<Directive>();
+    dir->type = Directive::Type::INCBIN;
+    dir->file = file;
+    dir->fileOffset = offset;
+    dir->fileBytes = length;
+    return dir;
+}
+
+std::unique_ptr<Directive> createEven() {
+    auto dir = std::make_unique<Directive>();
+    dir->type = Directive::Type::EVEN;
+    return dir;
+}
+
+std::unique_ptr<Directive> createOdd() {
+    auto dir = std::make_unique<Directive>();
+    dir->type = Directive::Type::ODD;
+    return dir;
+}
+
+std::unique_ptr<Directive> createRadix(int radix) {
+    auto dir = std::make_unique<Directive>();
+    dir->type = Directive::Type::RADIX;
+    dir->operands.push_back(createImm(radix));
+    return dir;
+}
+
+std::unique_ptr<Directive> createPsect(const std::string& name) {
+    auto dir = std::make_unique<Directive>();
+    dir->type = Directive::Type::PSECT;
+    dir->section = name;
     return dir;
 }
 
@@ -1,10 +1,12 @@
 #ifndef PDP11_AST_HPP
 #define PDP11_AST_HPP
 
+#include "diagnostics.hpp"
 #include <memory>
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cstddef>
 
 // ========================================================
 // 1. Режимы адресации PDP-11 (полный набор)
@@ -14,16 +16,37 @@ enum class AddrMode {
     IMMEDIATE,    // #42
     ABSOLUTE,     //@#address
     RELATIVE,     //address
+    RELATIVE_DEF, //@address
     REG_DEF,      //(Rn)
     AUTOINC,      //(Rn)+
     AUTODEC,      //-(Rn)
     INDEXED       //X(Rn)
 };
 
+// Атрибуты программного раздела (.PSECT)
+struct SectionAttributes {
+    bool readOnly = false; // RO / RW
+    bool data = false;     // D / I
+    bool overlay = false;  // OVR: каждый участок раздела с его начала; CON — подряд
+    uint16_t align = 2;    // Выравнивание начала раздела в байтах (степень двойки)
+
+    bool operator==(const SectionAttributes& other) const {
+        return readOnly == other.readOnly && data == other.data && overlay == other.overlay &&
+               align == other.align;
+    }
+    bool operator!=(const SectionAttributes& other) const { return !(*this == other); }
+};
+
 // ========================================================
 // 2. Базовые классы AST + Visitor Pattern
 // ========================================================
 struct ASTNode {
+    size_t line = 0;     // Строка исходника (0 — узел построен не парсером)
+    uint32_t column = 0; // Столбец начала оператора (с 1)
+    uint32_t length = 0; // Длина оператора в строке
+
+    SourceRange range() const { return {line, column, length}; }
+
     virtual ~ASTNode() = default;
     virtual void accept(class ASTVisitor& visitor) const = 0;
 };
@@ -45,6 +68,7 @@ struct Operand : ASTNode {
     std::string reg;    // Для регистров: "R1", "PC"
     int value = 0;      // Для чисел (#42, 0o52)
     std::string label;   // Для меток
+    uint16_t local = 0;  // n для локальной метки n$ (0 — обычная метка)
     
     void accept(ASTVisitor& visitor) const override {
         visitor.visit(*this);
@@ -67,10 +91,59 @@ struct Instruction : ASTNode {
 
 struct Directive : ASTNode {
     enum class Type {
-        WORD, BYTE, END, EQU, ASCII, FILL
+        WORD, BYTE, END, EQU, ASCII, FILL, RADIX, ASCIZ, BLKB, BLKW, INCBIN, EVEN, ODD, PSECT
     } type;
     
+    // Параметры служебных директив (.EQU, .RADIX)
     std::vector<std::unique_ptr<Operand>> operands;
+
+    // Директивы данных хранят содержимое одним куском, без узла на значение:
+    //   data    — байты .WORD/.BYTE/.ASCII/.ASCIZ (слова little-endian)
+    //   fixups  — слова data, куда после раскладки пишется адрес метки
+    //   fill    — повтор слова fillPattern на fillBytes байт (.FILL/.BLKB/.BLKW)
+    //   file    — fileBytes байт файла file со смещения fileOffset (.INCBIN);
+    //             размер известен по stat, содержимое читает только CodeGenerator
+    struct Fixup {
+        uint32_t offset; // Смещение слова в data
+        std::string label;
+        uint16_t local = 0; // n для локальной метки n$
+    };
+    std::vector<uint8_t> data;
+    std::vector<Fixup> fixups;
+    size_t fillBytes = 0;
+    uint16_t fillPattern = 0;
+    std::string file;
+    size_t fileOffset = 0;
+    size_t fileBytes = 0;
+
+    // .PSECT/.CSECT: раздел section (пустое имя — безымянный раздел, с
+    // которого начинается текст); attributes действуют, если hasAttributes
+    std::string section;
+    SectionAttributes attributes;
+    bool hasAttributes = false;
+
+    bool isData() const {
+        return type != Type::END && type != Type::EQU && type != Type::RADIX &&
+               type != Type::EVEN && type != Type::ODD && type != Type::PSECT;
+    }
+
+    // Данные, которые должны начинаться с чётного адреса
+    bool isWordData() const {
+        return type == Type::WORD || type == Type::FILL || type == Type::BLKW;
+    }
+
+    // Размер в образе в байтах (без выравнивания: .BYTE/.ASCII могут
+    // закончиться на нечётном адресе, выравнивает .EVEN)
+    size_t imageSize() const { return data.size() + fillBytes + fileBytes; }
+
+    void appendWord(uint16_t word) {
+        data.push_back(static_cast<uint8_t>(word & 0xFF));
+        data.push_back(static_cast<uint8_t>(word >> 8));
+    }
+    void appendFixup(std::string label, uint16_t local = 0) {
+        fixups.push_back({static_cast<uint32_t>(data.size()), std::move(label), local});
+        appendWord(0);
+    }
     
     void accept(ASTVisitor& visitor) const override {
         visitor.visit(*this);
@@ -79,6 +152,9 @@ struct Directive : ASTNode {
 
 struct Label : ASTNode {
     std::string name;
+    // n для локальной метки n$: она видна только до следующей обычной
+    // метки и в SymbolTable не попадает (см. CodeGenerator::beginBlock)
+    uint16_t local = 0;
     std::unique_ptr<ASTNode> statement;
     
     void accept(ASTVisitor& visitor) const override {
@@ -121,22 +197,32 @@ std::unique_ptr<Instruction> createAdd(
 std::unique_ptr<Instruction> createSub(
     std::unique_ptr<Operand> src,
     std::unique_ptr<Operand> dst);
-std::unique_ptr<Instruction> createJsr(const std::string& target);
-std::unique_ptr<Instruction> createRts();
+std::unique_ptr<Instruction> createJsr(
+    std::unique_ptr<Operand> reg,
+    std::unique_ptr<Operand> dst);
+std::unique_ptr<Instruction> createRts(std::unique_ptr<Operand> reg);
 std::unique_ptr<Instruction> createHalt();
 std::unique_ptr<Instruction> createClr(std::unique_ptr<Operand> dst);
 std::unique_ptr<Instruction> createCom(std::unique_ptr<Operand> dst);
 std::unique_ptr<Instruction> createInc(std::unique_ptr<Operand> dst);
 std::unique_ptr<Instruction> createDec(std::unique_ptr<Operand> dst);
 std::unique_ptr<Instruction> createNeg(std::unique_ptr<Operand> dst);
-std::unique_ptr<Instruction> createJmp(const std::string& target);
+std::unique_ptr<Instruction> createJmp(std::unique_ptr<Operand> dst);
 
 std::unique_ptr<Directive> createWord(std::vector<std::unique_ptr<Operand>> values);
 std::unique_ptr<Directive> createByte(std::vector<std::unique_ptr<Operand>> values);
 std::unique_ptr<Directive> createAscii(const std::string& text);
+std::unique_ptr<Directive> createAsciz(const std::string& text);
+std::unique_ptr<Directive> createBlkb(int count);
+std::unique_ptr<Directive> createBlkw(int count);
+std::unique_ptr<Directive> createIncbin(const std::string& file, size_t offset, size_t length);
+std::unique_ptr<Directive> createEven();
+std::unique_ptr<Directive> createOdd();
 std::unique_ptr<Directive> createEqu(const std::string& label, int value);
 std::unique_ptr<Directive> createEnd();
 std::unique_ptr<Directive> createFill(int count, int value);
+std::unique_ptr<Directive> createRadix(int radix);
+std::unique_ptr<Directive> createPsect(const std::string& name);
 
 std::unique_ptr<Label> createLabel(const std::string& name, std::unique_ptr<ASTNode> statement);
 }
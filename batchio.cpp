@@ -0,0 +1,470 @@
+#include "batchio.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#if __has_include(<linux/io_uring.h>) && __has_include(<sys/syscall.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_SINGLE_MMAP)
+#define PDP11_IO_URING 1
+#endif
+
+// Одна операция в кольце — не больше гигабайта; остаток дочитывается pread
+static constexpr size_t MAX_OPERATION = size_t(1) << 30;
+
+static std::string failure(const char* what, const std::string& path, int error) {
+    return std::string(what) + " " + path + ": " + std::strerror(error);
+}
+
+// ========================================================
+// 1. Кольцо io_uring
+// ========================================================
+#ifdef PDP11_IO_URING
+
+struct BatchIO::Ring {
+    static constexpr unsigned ENTRIES = 256;
+
+    int fd = -1;
+    unsigned entries = 0;
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    size_t sqSize = 0, cqSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    unsigned *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) ::munmap(sqes, entries * sizeof(io_uring_sqe));
+        if (cqRing != MAP_FAILED && cqRing != sqRing) ::munmap(cqRing, cqSize);
+        if (sqRing != MAP_FAILED) ::munmap(sqRing, sqSize);
+        if (fd >= 0) ::close(fd);
+    }
+
+    // nullptr, если кольцо не создаётся или ядро не знает нужных операций
+    static std::unique_ptr<Ring> create() {
+        auto ring = std::make_unique<Ring>();
+        io_uring_params params{};
+        ring->fd = static_cast<int>(::syscall(__NR_io_uring_setup, ENTRIES, &params));
+        if (ring->fd < 0) return nullptr;
+        ring->entries = params.sq_entries;
+
+        ring->sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) ring->sqSize = ring->cqSize = std::max(ring->sqSize, ring->cqSize);
+        ring->sqRing = ::mmap(nullptr, ring->sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              ring->fd, IORING_OFF_SQ_RING);
+        if (ring->sqRing == MAP_FAILED) return nullptr;
+        ring->cqRing = single ? ring->sqRing
+                              : ::mmap(nullptr, ring->cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                       ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cqRing == MAP_FAILED) return nullptr;
+        ring->sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, ring->entries * sizeof(io_uring_sqe),
+                                                       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                                       ring->fd, IORING_OFF_SQES));
+        if (ring->sqes == MAP_FAILED) return nullptr;
+
+        auto* sq = static_cast<char*>(ring->sqRing);
+        auto* cq = static_cast<char*>(ring->cqRing);
+        ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring->sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        ring->cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Операции с файлами появились в разных версиях ядра: проверяем все
+        constexpr unsigned PROBE_OPS = 256;
+        std::vector<char> buffer(sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op), 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+        if (::syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, PROBE_OPS) < 0) return nullptr;
+        for (unsigned op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_CLOSE, IORING_OP_READ, IORING_OP_WRITE,
+                            IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return nullptr;
+        }
+        return ring;
+    }
+
+    bool enter(unsigned submit, unsigned wait, int& submitted, size_t& calls) {
+        for (;;) {
+            calls++;
+            long n = ::syscall(__NR_io_uring_enter, fd, submit, wait, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (n >= 0) {
+                submitted = static_cast<int>(n);
+                return true;
+            }
+            if (errno != EINTR) return false;
+        }
+    }
+
+    // Операции пачками по размеру кольца: один io_uring_enter на пачку
+    // (подача и ожидание всех завершений). results — res по порядку ops
+    void run(std::vector<io_uring_sqe>& ops, std::vector<int32_t>& results, size_t& calls) {
+        results.assign(ops.size(), -ECANCELED);
+        for (size_t done = 0; done < ops.size();) {
+            auto count = static_cast<unsigned>(std::min<size_t>(entries, ops.size() - done));
+            unsigned tail = *sqTail;
+            for (unsigned i = 0; i < count; i++) {
+                unsigned index = (tail + i) & *sqMask;
+                ops[done + i].user_data = done + i;
+                sqes[index] = ops[done + i];
+                sqArray[index] = index;
+            }
+            __atomic_store_n(sqTail, tail + count, __ATOMIC_RELEASE);
+
+            unsigned submitted = 0, reaped = 0;
+            while (reaped < count) {
+                int n = 0;
+                if (!enter(count - submitted, count - reaped, n, calls)) {
+                    // Кольцо сломалось: неподанные операции остаются ECANCELED
+                    if (submitted == 0) __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+                    return;
+                }
+                submitted += static_cast<unsigned>(n);
+
+                unsigned head = *cqHead;
+                unsigned ready = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+                for (; head != ready; head++) {
+                    const io_uring_cqe& cqe = cqes[head & *cqMask];
+                    results[cqe.user_data] = cqe.res;
+                    reaped++;
+                }
+                __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            }
+            done += count;
+        }
+    }
+
+    // Буфер пакета как зарегистрированный (для *_FIXED); false — не вышло
+    // (например, лимит закреплённой памяти), тогда обычные READ/WRITE
+    bool registerBuffer(std::vector<char>& buffer, size_t& calls) {
+        if (buffer.empty() || buffer.size() > MAX_OPERATION) return false;
+        iovec vec{buffer.data(), buffer.size()};
+        calls++;
+        return ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &vec, 1) == 0;
+    }
+
+    void unregisterBuffer(size_t& calls) {
+        calls++;
+        ::syscall(__NR_io_uring_register, fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+    }
+};
+
+static io_uring_sqe operation(uint8_t opcode, int fd, const void* addr, uint32_t len, uint64_t offset) {
+    io_uring_sqe sqe{};
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uint64_t>(addr);
+    sqe.len = len;
+    sqe.off = offset;
+    return sqe;
+}
+
+#else
+
+struct BatchIO::Ring {
+    static std::unique_ptr<Ring> create() { return nullptr; }
+};
+
+#endif
+
+BatchIO::BatchIO() : ring(Ring::create()) {}
+
+BatchIO::~BatchIO() = default;
+
+const char* BatchIO::backend() const {
+    return ring ? "io_uring" : "pread/pwrite";
+}
+
+// Дочитывание после короткого чтения: done — уже прочитано
+bool BatchIO::readRest(int fd, char* data, size_t size, size_t& done) {
+    while (done < size) {
+        calls++;
+        ssize_t n = ::pread(fd, data + done, size - done, static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) break; // Файл укоротился
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool BatchIO::writeRest(int fd, const char* data, size_t size, size_t done) {
+    while (done < size) {
+        calls++;
+        ssize_t n = ::pwrite(fd, data + done, size - done, static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// ========================================================
+// 2. Части пакета
+// ========================================================
+// Дескрипторы вне пакета: stdin/stdout/stderr, кольцо, кеш и прочее
+static constexpr size_t RESERVED_FDS = 32;
+
+size_t BatchIO::filesAtOnce() {
+    struct rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) return SIZE_MAX;
+    size_t open = static_cast<size_t>(limit.rlim_cur);
+    return open > 2 * RESERVED_FDS ? open - RESERVED_FDS : std::max<size_t>(open / 2, 1);
+}
+
+// ========================================================
+// 3. Чтение
+// ========================================================
+std::vector<BatchIO::Input> BatchIO::readFiles(const std::vector<std::string>& paths) {
+    size_t n = paths.size();
+    std::vector<Input> inputs(n);
+    std::vector<Span> spans(n);
+    size_t chunk = filesAtOnce();
+    readBuffer.clear();
+    for (size_t first = 0; first < n; first += std::min(chunk, n - first)) {
+        size_t last = first + std::min(chunk, n - first);
+        if (ring) readRing(paths, first, last, inputs, spans);
+        else readPlain(paths, first, last, inputs, spans);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (inputs[i].error.empty()) inputs[i].bytes = std::string_view(readBuffer.data() + spans[i].offset, spans[i].size);
+    }
+    return inputs;
+}
+
+#ifdef PDP11_IO_URING
+void BatchIO::readRing(const std::vector<std::string>& paths, size_t first, size_t last, std::vector<Input>& inputs,
+                       std::vector<Span>& spans) {
+    size_t n = last - first;
+    std::vector<io_uring_sqe> ops;
+    std::vector<int32_t> results;
+
+    // Открытие и размер: две операции на файл в одной пачке
+    std::vector<struct statx> stats(n);
+    ops.reserve(2 * n);
+    for (size_t k = 0; k < n; k++) {
+        auto open = operation(IORING_OP_OPENAT, AT_FDCWD, paths[first + k].c_str(), 0, 0);
+        open.open_flags = O_RDONLY | O_CLOEXEC;
+        ops.push_back(open);
+        auto stat = operation(IORING_OP_STATX, AT_FDCWD, paths[first + k].c_str(), STATX_SIZE,
+                              reinterpret_cast<uint64_t>(&stats[k]));
+        ops.push_back(stat);
+    }
+    ring->run(ops, results, calls);
+
+    // Часть дописывается в конец буфера
+    std::vector<int> fds(n, -1);
+    std::vector<size_t> offsets(n + 1, readBuffer.size());
+    for (size_t k = 0; k < n; k++) {
+        size_t i = first + k;
+        int32_t opened = results[2 * k], stated = results[2 * k + 1];
+        if (opened >= 0) fds[k] = opened;
+        if (opened < 0) inputs[i].error = failure("cannot open", paths[i], -opened);
+        else if (stated < 0) inputs[i].error = failure("cannot stat", paths[i], -stated);
+        size_t size = inputs[i].error.empty() ? static_cast<size_t>(stats[k].stx_size) : 0;
+        offsets[k + 1] = offsets[k] + size;
+    }
+
+    // Чтение всех файлов части в один зарегистрированный буфер
+    readBuffer.resize(offsets[n]);
+    bool fixed = ring->registerBuffer(readBuffer, calls);
+    ops.clear();
+    std::vector<size_t> files;
+    for (size_t k = 0; k < n; k++) {
+        size_t size = offsets[k + 1] - offsets[k];
+        if (!inputs[first + k].error.empty() || size == 0) continue;
+        auto read = operation(fixed ? IORING_OP_READ_FIXED : IORING_OP_READ, fds[k], readBuffer.data() + offsets[k],
+                              static_cast<uint32_t>(std::min(size, MAX_OPERATION)), 0);
+        read.buf_index = 0;
+        ops.push_back(read);
+        files.push_back(k);
+    }
+    ring->run(ops, results, calls);
+    if (fixed) ring->unregisterBuffer(calls);
+
+    std::vector<size_t> got(n, 0);
+    for (size_t j = 0; j < files.size(); j++) {
+        size_t k = files[j], i = first + k;
+        if (results[j] < 0) {
+            inputs[i].error = failure("cannot read", paths[i], -results[j]);
+            continue;
+        }
+        got[k] = static_cast<size_t>(results[j]);
+        if (!readRest(fds[k], readBuffer.data() + offsets[k], offsets[k + 1] - offsets[k], got[k])) {
+            inputs[i].error = failure("cannot read", paths[i], errno);
+        }
+    }
+
+    ops.clear();
+    for (size_t k = 0; k < n; k++) {
+        if (fds[k] >= 0) ops.push_back(operation(IORING_OP_CLOSE, fds[k], nullptr, 0, 0));
+        spans[first + k] = {offsets[k], got[k]};
+    }
+    ring->run(ops, results, calls);
+}
+#else
+void BatchIO::readRing(const std::vector<std::string>& paths, size_t first, size_t last, std::vector<Input>& inputs,
+                       std::vector<Span>& spans) {
+    readPlain(paths, first, last, inputs, spans);
+}
+#endif
+
+void BatchIO::readPlain(const std::vector<std::string>& paths, size_t first, size_t last, std::vector<Input>& inputs,
+                        std::vector<Span>& spans) {
+    size_t n = last - first;
+    std::vector<int> fds(n, -1);
+    std::vector<size_t> offsets(n + 1, readBuffer.size());
+    for (size_t k = 0; k < n; k++) {
+        size_t i = first + k;
+        struct stat st{};
+        calls++;
+        fds[k] = ::open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+        if (fds[k] < 0) {
+            inputs[i].error = failure("cannot open", paths[i], errno);
+        } else {
+            calls++;
+            if (::fstat(fds[k], &st) != 0) inputs[i].error = failure("cannot stat", paths[i], errno);
+        }
+        offsets[k + 1] = offsets[k] + (inputs[i].error.empty() ? static_cast<size_t>(st.st_size) : 0);
+    }
+
+    readBuffer.resize(offsets[n]);
+    for (size_t k = 0; k < n; k++) {
+        size_t i = first + k, got = 0;
+        if (inputs[i].error.empty() &&
+            !readRest(fds[k], readBuffer.data() + offsets[k], offsets[k + 1] - offsets[k], got)) {
+            inputs[i].error = failure("cannot read", paths[i], errno);
+        }
+        spans[i] = {offsets[k], got};
+    }
+    for (int fd : fds) {
+        if (fd < 0) continue;
+        calls++;
+        ::close(fd);
+    }
+}
+
+// ========================================================
+// 4. Запись
+// ========================================================
+std::vector<std::string> BatchIO::writeFiles(const std::vector<Output>& outputs) {
+    size_t n = outputs.size();
+    std::vector<size_t> offsets(n + 1, 0);
+    for (size_t i = 0; i < n; i++) offsets[i + 1] = offsets[i] + outputs[i].bytes.size();
+    writeBuffer.resize(offsets[n]);
+    for (size_t i = 0; i < n; i++) {
+        std::memcpy(writeBuffer.data() + offsets[i], outputs[i].bytes.data(), outputs[i].bytes.size());
+    }
+
+    std::vector<std::string> errors(n);
+    size_t chunk = filesAtOnce();
+    for (size_t first = 0; first < n; first += std::min(chunk, n - first)) {
+        size_t last = first + std::min(chunk, n - first);
+        if (ring) writeRing(outputs, first, last, offsets, errors);
+        else writePlain(outputs, first, last, offsets, errors);
+    }
+    return errors;
+}
+
+#ifdef PDP11_IO_URING
+void BatchIO::writeRing(const std::vector<Output>& outputs, size_t first, size_t last,
+                        const std::vector<size_t>& offsets, std::vector<std::string>& errors) {
+    size_t n = last - first;
+    std::vector<io_uring_sqe> ops;
+    std::vector<int32_t> results;
+
+    ops.reserve(n);
+    for (size_t i = first; i < last; i++) {
+        auto open = operation(IORING_OP_OPENAT, AT_FDCWD, outputs[i].path.c_str(), 0666, 0);
+        open.open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        ops.push_back(open);
+    }
+    ring->run(ops, results, calls);
+    std::vector<int> fds(n, -1);
+    for (size_t k = 0; k < n; k++) {
+        if (results[k] >= 0) fds[k] = results[k];
+        else errors[first + k] = failure("cannot create", outputs[first + k].path, -results[k]);
+    }
+
+    bool fixed = ring->registerBuffer(writeBuffer, calls);
+    ops.clear();
+    std::vector<size_t> files;
+    for (size_t k = 0; k < n; k++) {
+        size_t i = first + k, size = offsets[i + 1] - offsets[i];
+        if (fds[k] < 0 || size == 0) continue;
+        auto write = operation(fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, fds[k],
+                               writeBuffer.data() + offsets[i], static_cast<uint32_t>(std::min(size, MAX_OPERATION)), 0);
+        write.buf_index = 0;
+        ops.push_back(write);
+        files.push_back(k);
+    }
+    ring->run(ops, results, calls);
+    if (fixed) ring->unregisterBuffer(calls);
+
+    for (size_t j = 0; j < files.size(); j++) {
+        size_t k = files[j], i = first + k;
+        if (results[j] < 0) {
+            errors[i] = failure("cannot write", outputs[i].path, -results[j]);
+        } else if (!writeRest(fds[k], writeBuffer.data() + offsets[i], offsets[i + 1] - offsets[i],
+                              static_cast<size_t>(results[j]))) {
+            errors[i] = failure("cannot write", outputs[i].path, errno);
+        }
+    }
+
+    ops.clear();
+    files.clear();
+    for (size_t k = 0; k < n; k++) {
+        if (fds[k] < 0) continue;
+        ops.push_back(operation(IORING_OP_CLOSE, fds[k], nullptr, 0, 0));
+        files.push_back(first + k);
+    }
+    ring->run(ops, results, calls);
+    for (size_t j = 0; j < files.size(); j++) {
+        if (results[j] < 0 && errors[files[j]].empty()) {
+            errors[files[j]] = failure("cannot write", outputs[files[j]].path, -results[j]);
+        }
+    }
+}
+#else
+void BatchIO::writeRing(const std::vector<Output>& outputs, size_t first, size_t last,
+                        const std::vector<size_t>& offsets, std::vector<std::string>& errors) {
+    writePlain(outputs, first, last, offsets, errors);
+}
+#endif
+
+void BatchIO::writePlain(const std::vector<Output>& outputs, size_t first, size_t last,
+                         const std::vector<size_t>& offsets, std::vector<std::string>& errors) {
+    size_t n = last - first;
+    std::vector<int> fds(n, -1);
+    for (size_t k = 0; k < n; k++) {
+        size_t i = first + k;
+        calls++;
+        fds[k] = ::open(outputs[i].path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (fds[k] < 0) errors[i] = failure("cannot create", outputs[i].path, errno);
+    }
+    for (size_t k = 0; k < n; k++) {
+        size_t i = first + k;
+        if (fds[k] >= 0 && !writeRest(fds[k], writeBuffer.data() + offsets[i], offsets[i + 1] - offsets[i], 0)) {
+            errors[i] = failure("cannot write", outputs[i].path, errno);
+        }
+    }
+    for (size_t k = 0; k < n; k++) {
+        if (fds[k] < 0) continue;
+        calls++;
+        if (::close(fds[k]) != 0 && errors[first + k].empty()) {
+            errors[first + k] = failure("cannot write", outputs[first + k].path, errno);
+        }
+    }
+}
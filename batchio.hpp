@@ -0,0 +1,79 @@
+#ifndef PDP11_BATCHIO_HPP
+#define PDP11_BATCHIO_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// ========================================================
+// Пакетный ввод-вывод файлов (--batch)
+// ========================================================
+// Файлы пакета проходят каждую фазу вместе: открытие и размер,
+// чтение (или запись), закрытие. Одновременно открыто не больше файлов,
+// чем позволяет RLIMIT_NOFILE: длинный пакет идёт частями, и дескрипторы
+// части закрываются до открытия следующей. С io_uring фаза — пачка
+// операций в кольце и один io_uring_enter на пачку, а не системный
+// вызов на файл.
+// Данные лежат в одном буфере, зарегистрированном в кольце
+// (READ_FIXED/WRITE_FIXED: ядро не отображает страницы на каждую
+// операцию). Кольцо создаётся прямыми системными вызовами, без liburing.
+// Если io_uring нет (старое ядро, запрет в seccomp или
+// kernel.io_uring_disabled) — те же фазы через open/pread/pwrite.
+class BatchIO {
+public:
+    struct Input {
+        std::string_view bytes; // Содержимое (живёт до следующего readFiles)
+        std::string error;      // Пусто, если файл прочитан
+    };
+
+    struct Output {
+        std::string path;
+        std::string_view bytes;
+    };
+
+    BatchIO();
+    ~BatchIO();
+    BatchIO(const BatchIO&) = delete;
+    BatchIO& operator=(const BatchIO&) = delete;
+
+    std::vector<Input> readFiles(const std::vector<std::string>& paths);
+
+    // Ошибка записи для каждого файла (пусто — записан)
+    std::vector<std::string> writeFiles(const std::vector<Output>& outputs);
+
+    const char* backend() const;
+    size_t syscalls() const { return calls; } // Системных вызовов ввода-вывода
+
+private:
+    struct Ring;
+    std::unique_ptr<Ring> ring;      // Нет — запасной путь pread/pwrite
+    std::vector<char> readBuffer;    // Содержимое прочитанных файлов подряд
+    std::vector<char> writeBuffer;   // Записываемые файлы подряд
+    size_t calls = 0;
+
+    // Прочитанный файл в readBuffer: буфер растёт от части к части,
+    // поэтому Input::bytes заполняются после последней
+    struct Span {
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    static size_t filesAtOnce();
+
+    // Файлы [first, last)
+    void readRing(const std::vector<std::string>& paths, size_t first, size_t last, std::vector<Input>& inputs,
+                  std::vector<Span>& spans);
+    void readPlain(const std::vector<std::string>& paths, size_t first, size_t last, std::vector<Input>& inputs,
+                   std::vector<Span>& spans);
+    void writeRing(const std::vector<Output>& outputs, size_t first, size_t last, const std::vector<size_t>& offsets,
+                   std::vector<std::string>& errors);
+    void writePlain(const std::vector<Output>& outputs, size_t first, size_t last, const std::vector<size_t>& offsets,
+                    std::vector<std::string>& errors);
+    bool readRest(int fd, char* data, size_t size, size_t& done);
+    bool writeRest(int fd, const char* data, size_t size, size_t done);
+};
+
+#endif // PDP11_BATCHIO_HPP
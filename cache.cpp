@@ -0,0 +1,220 @@
+#include "cache.hpp"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Менять при любом изменении кодирования или формата записи
+static constexpr const char* ASSEMBLER_VERSION = "pdp11-asm 2";
+static constexpr uint32_t FORMAT_VERSION = 4;
+static constexpr size_t HEADER_SIZE = 4 + 7 * 4;
+static constexpr int SECTIONS = 6;
+
+namespace {
+
+uint32_t getU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+bool writeFull(int fd, const char* p, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Строка отпечатка одного файла; отсутствующий файл — размер -1
+std::string fingerprintLine(std::string_view path) {
+    struct stat st;
+    std::string line;
+    if (::stat(std::string(path).c_str(), &st) == 0) {
+        line = std::to_string(st.st_size) + " " + std::to_string(st.st_mtim.tv_sec) + "." +
+               std::to_string(st.st_mtim.tv_nsec);
+    } else {
+        line = "-1 0.0";
+    }
+    line += " ";
+    line += path;
+    line += "\n";
+    return line;
+}
+
+// Все ли зависимости записи остались такими же
+bool dependenciesCurrent(std::string_view recorded) {
+    while (!recorded.empty()) {
+        size_t eol = recorded.find('\n');
+        if (eol == std::string_view::npos) return false;
+        std::string_view line = recorded.substr(0, eol + 1);
+        size_t space = line.find(' ', line.find(' ') + 1);
+        if (space == std::string_view::npos) return false;
+        std::string_view path = line.substr(space + 1, line.size() - space - 2);
+        if (fingerprintLine(path) != line) return false;
+        recorded.remove_prefix(eol + 1);
+    }
+    return true;
+}
+
+} // namespace
+
+// ========================================================
+// 1. Ключ
+// ========================================================
+AssemblyCache::Key& AssemblyCache::Key::add(std::string_view bytes) {
+    // Длина впереди: "ab"+"c" и "a"+"bc" дают разные ключи
+    add(static_cast<uint64_t>(bytes.size()));
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return *this;
+}
+
+AssemblyCache::Key& AssemblyCache::Key::add(uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        hash ^= (value >> (8 * i)) & 0xFF;
+        hash *= 1099511628211ull;
+    }
+    return *this;
+}
+
+std::string AssemblyCache::Key::hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(16, '0');
+    for (int i = 0; i < 16; i++) text[15 - i] = digits[(hash >> (4 * i)) & 0xF];
+    return text;
+}
+
+AssemblyCache::Key AssemblyCache::baseKey() {
+    Key key;
+    key.add(ASSEMBLER_VERSION);
+    // Пересобранный ассемблер не должен брать чужие записи
+    struct stat st;
+    if (::stat("/proc/self/exe", &st) == 0) {
+        key.add(static_cast<uint64_t>(st.st_size));
+        key.add(static_cast<uint64_t>(st.st_mtime));
+    }
+    return key;
+}
+
+std::string AssemblyCache::fingerprint(const std::vector<std::string>& files) {
+    std::string text;
+    for (const auto& file : files) text += fingerprintLine(file);
+    return text;
+}
+
+std::string AssemblyCache::pathFor(const Key& key) const {
+    return directory + "/" + key.hex() + ".p11c";
+}
+
+// ========================================================
+// 2. Чтение (mmap)
+// ========================================================
+AssemblyCache::Entry::Entry(Entry&& other) noexcept {
+    *this = std::move(other);
+}
+
+AssemblyCache::Entry& AssemblyCache::Entry::operator=(Entry&& other) noexcept {
+    if (this != &other) {
+        if (base) ::munmap(base, size);
+        base = other.base;
+        size = other.size;
+        sections = other.sections;
+        other.base = nullptr;
+        other.size = 0;
+    }
+    return *this;
+}
+
+AssemblyCache::Entry::~Entry() {
+    if (base) ::munmap(base, size);
+}
+
+bool AssemblyCache::lookup(const Key& key, Entry& entry) const {
+    int fd = ::open(pathFor(key).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return false;
+
+    Entry found;
+    found.base = base;
+    found.size = size;
+
+    auto* p = static_cast<const uint8_t*>(base);
+    if (std::memcmp(p, "P11C", 4) != 0 || getU32(p + 4) != FORMAT_VERSION) return false;
+
+    // Длины секций должны точно покрывать файл
+    uint64_t lengths[SECTIONS];
+    uint64_t total = HEADER_SIZE;
+    for (int i = 0; i < SECTIONS; i++) {
+        lengths[i] = getU32(p + 8 + 4 * i);
+        total += lengths[i];
+    }
+    if (total != size) return false;
+
+    const char* data = reinterpret_cast<const char*>(p + HEADER_SIZE);
+    std::string_view* views[SECTIONS] = {&found.sections.image, &found.sections.symbols,
+                                         &found.sections.diagnostics, &found.sections.report,
+                                         &found.sections.lines, &found.sections.dependencies};
+    for (int i = 0; i < SECTIONS; i++) {
+        *views[i] = std::string_view(data, lengths[i]);
+        data += lengths[i];
+    }
+    if (!dependenciesCurrent(found.sections.dependencies)) return false;
+
+    entry = std::move(found);
+    return true;
+}
+
+// ========================================================
+// 3. Запись (временный файл + rename)
+// ========================================================
+bool AssemblyCache::store(const Key& key, const Artifact& artifact) const {
+    ::mkdir(directory.c_str(), 0777);
+
+    std::string header = "P11C";
+    putU32(header, FORMAT_VERSION);
+    putU32(header, static_cast<uint32_t>(artifact.image.size()));
+    putU32(header, static_cast<uint32_t>(artifact.symbols.size()));
+    putU32(header, static_cast<uint32_t>(artifact.diagnostics.size()));
+    putU32(header, static_cast<uint32_t>(artifact.report.size()));
+    putU32(header, static_cast<uint32_t>(artifact.lines.size()));
+    putU32(header, static_cast<uint32_t>(artifact.dependencies.size()));
+
+    std::string path = pathFor(key);
+    std::string temp = path + ".tmp." + std::to_string(::getpid());
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+
+    bool ok = writeFull(fd, header.data(), header.size()) &&
+              writeFull(fd, artifact.image.data(), artifact.image.size()) &&
+              writeFull(fd, artifact.symbols.data(), artifact.symbols.size()) &&
+              writeFull(fd, artifact.diagnostics.data(), artifact.diagnostics.size()) &&
+              writeFull(fd, artifact.report.data(), artifact.report.size()) &&
+              writeFull(fd, artifact.lines.data(), artifact.lines.size()) &&
+              writeFull(fd, artifact.dependencies.data(), artifact.dependencies.size());
+    ok = ::close(fd) == 0 && ok;
+
+    if (!ok || ::rename(temp.c_str(), path.c_str()) != 0) {
+        ::unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
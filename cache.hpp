@@ -0,0 +1,86 @@
+#ifndef PDP11_CACHE_HPP
+#define PDP11_CACHE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// ========================================================
+// Кеш результатов ассемблирования на диске (по содержимому)
+// ========================================================
+// Имя файла — 64-битный хеш всего, что влияет на результат:
+// версия и сборка ассемблера, опции, исходник (и его зависимости).
+// Формат файла (числа — uint32, little-endian):
+//   "P11C" [версия формата] [длина образа][длина символов]
+//   [длина диагностики][длина отчёта][длина таблицы строк]
+//   [длина списка зависимостей], затем сами секции.
+// Файлы .INCBIN известны только после разбора, поэтому в ключ не
+// входят: запись хранит их размеры и время изменения (fingerprint),
+// и lookup считает запись устаревшей, если какой-то файл изменился.
+// Запись атомарна: временный файл в том же каталоге + rename,
+// поэтому параллельные сборки могут делить один каталог.
+class AssemblyCache {
+public:
+    // Накопитель ключа: FNV-1a (64 бита)
+    class Key {
+    public:
+        Key& add(std::string_view bytes);
+        Key& add(uint64_t value);
+        std::string hex() const;
+
+    private:
+        uint64_t hash = 14695981039346656037ull;
+    };
+
+    // Секции записи кеша
+    struct Artifact {
+        std::string_view image;       // Байты образа, как в .bin
+        std::string_view symbols;     // Символы в формате SymbolFile
+        std::string_view diagnostics; // Строки "line:col: severity: msg"
+        std::string_view report;      // Всё, что печаталось после сборки
+        std::string_view lines;       // LineTable::encode
+        std::string_view dependencies; // fingerprint() файлов .INCBIN
+    };
+
+    // Найденная запись: файл отображён в память только для чтения
+    class Entry {
+    public:
+        Entry() = default;
+        Entry(Entry&& other) noexcept;
+        Entry& operator=(Entry&& other) noexcept;
+        Entry(const Entry&) = delete;
+        Entry& operator=(const Entry&) = delete;
+        ~Entry();
+
+        const Artifact& artifact() const { return sections; }
+
+    private:
+        friend class AssemblyCache;
+        void* base = nullptr;
+        size_t size = 0;
+        Artifact sections;
+    };
+
+    explicit AssemblyCache(std::string directory) : directory(std::move(directory)) {}
+
+    // Ключ с версией ассемблера и отпечатком исполняемого файла
+    static Key baseKey();
+
+    // Отпечаток файлов-зависимостей: по строке "размер время путь"
+    static std::string fingerprint(const std::vector<std::string>& files);
+
+    // false — записи нет, она повреждена или зависимости изменились
+    bool lookup(const Key& key, Entry& entry) const;
+
+    // Ошибки записи не фатальны: кеш лишь ускоряет сборку
+    bool store(const Key& key, const Artifact& artifact) const;
+
+private:
+    std::string directory;
+
+    std::string pathFor(const Key& key) const;
+};
+
+#endif // PDP11_CACHE_HPP
@@ -1,200 +1,431 @@
 #include "codegen.hpp"
+#include "isa.hpp"
+#include "probes.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <iostream>
 
-std::vector<uint16_t> CodeGenerator::generate(Program& program) {
+// Байты .INCBIN: файл отображается в память и копируется прямо в образ
+static void copyIncbin(const Directive& dir, uint8_t* out) {
+    if (dir.fileBytes == 0) return;
+    int fd = ::open(dir.file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Cannot open .INCBIN file: " + dir.file);
+
+    // Файл мог укоротиться после раскладки
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < dir.fileOffset + dir.fileBytes) {
+        ::close(fd);
+        throw std::runtime_error(".INCBIN file changed during assembly: " + dir.file);
+    }
+    // Смещение mmap кратно странице
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t skip = dir.fileOffset % page;
+    size_t length = skip + dir.fileBytes;
+    void* base = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(dir.fileOffset - skip));
+    ::close(fd);
+    if (base == MAP_FAILED) throw std::runtime_error("Cannot map .INCBIN file: " + dir.file);
+
+    ::madvise(base, length, MADV_SEQUENTIAL);
+    std::memcpy(out, static_cast<const uint8_t*>(base) + skip, dir.fileBytes);
+    ::munmap(base, length);
+}
+
+std::vector<uint16_t> CodeGenerator::generate(const Program& program) {
+    std::vector<uint16_t> out;
+    generate(program, out);
+    return out;
+}
+
+void CodeGenerator::generate(const Program& program, std::vector<uint16_t>& out) {
+    if (!symtab.sections().single()) {
+        generateSections(program, out);
+        return;
+    }
+    output.swap(out);
     output.clear();
     current_pc = 0;
+    halfWord = false;
+    current_block.clear();
     program.accept(*this);
-    return output;
+    out.swap(output);
 }
 
 void CodeGenerator::emit(uint16_t word) {
+#ifdef PDP11_DEBUG
     printf("Writing in bin: %04o (hex: %04X)\n", word, word);
+#endif
     output.push_back(word);
-    current_pc++;
+    current_pc += 2; // Адреса PDP-11 байтовые
 }
 
 void CodeGenerator::visit(const Program& program) {
-    for (const auto& stmt : program.statements) {
-        stmt->accept(*this);
+    generateRun(program, 0, program.statements.size());
+}
+
+// Операторы [first, last) подряд с адреса current_pc
+void CodeGenerator::generateRun(const Program& program, size_t first, size_t last) {
+    blockEnd = first;
+    for (size_t i = first; i < last; i++) {
+        if (i == blockEnd) beginBlock(program, i, last);
+        // Ошибки кодирования (неизвестный символ, регистр, .INCBIN)
+        // относятся к оператору, на котором возникли
+        try {
+            program.statements[i]->accept(*this);
+        }
+        catch (const AssemblyError&) {
+            throw;
+        }
+        catch (const std::runtime_error& e) {
+            throw AssemblyError(program.statements[i]->range(), e.what());
+        }
+    }
+}
+
+// ========================================================
+// Разделы
+// ========================================================
+
+// Раздел целиком: его участки по порядку с базы раздела. У OVR каждый
+// участок начинается с начала раздела и накладывается на прежние
+void CodeGenerator::generateSection(const Program& program, uint32_t section, std::vector<uint16_t>& out) {
+    const auto& layout = symtab.sections();
+    const auto& info = layout.sections()[section];
+    bool overlay = info.attributes.overlay;
+    output.clear();
+    halfWord = false;
+    current_block.clear();
+    out.clear();
+
+    for (const auto& run : layout.runs()) {
+        if (run.section != section) continue;
+        if (overlay) {
+            output.clear();
+            halfWord = false;
+        }
+        current_pc = static_cast<uint16_t>(info.base + run.start);
+        size_t relocated = relocations ? relocations->size() : 0;
+        generateRun(program, run.first, run.last);
+        if (overlay) {
+            size_t bytes = 2 * output.size() - (halfWord ? 1 : 0);
+            if (relocations) {
+                // Слова прежних участков под этим участком затёрты
+                uint32_t begin = info.base, end = info.base + static_cast<uint32_t>(bytes);
+                auto stale = std::remove_if(relocations->begin(), relocations->begin() + relocated,
+                                            [&](const Relocation& r) { return r.address >= begin && r.address < end; });
+                relocations->erase(stale, relocations->begin() + relocated);
+            }
+            if (out.size() < output.size()) out.resize(output.size(), 0);
+            std::memcpy(out.data(), output.data(), bytes);
+        }
+    }
+    if (!overlay) {
+        out.swap(output);
+    } else if (relocations) {
+        std::sort(relocations->begin(), relocations->end(),
+                  [](const Relocation& a, const Relocation& b) { return a.address < b.address; });
+    }
+}
+
+// Адреса уже разложены, поэтому разделы не зависят друг от друга: потоки
+// разбирают их по счётчику, ссылки между разделами разрешаются сразу.
+// Потоков не больше непустых разделов и бюджета setThreads; при одном
+// всё кодируется в вызывающем потоке
+void CodeGenerator::generateSections(const Program& program, std::vector<uint16_t>& out) {
+    const auto& sections = symtab.sections().sections();
+    struct Part {
+        std::vector<uint16_t> words;
+        std::vector<EncodedInstruction> instructions;
+        LineTable lines;
+        std::vector<FillRun> fills;
+        std::vector<Relocation> relocations;
+        std::exception_ptr error;
+    };
+    std::vector<Part> parts(sections.size());
+
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t s; (s = next.fetch_add(1)) < sections.size();) {
+            if (sections[s].size == 0) continue;
+            CodeGenerator generator(symtab);
+            if (instructions) generator.recordInstructions(&parts[s].instructions);
+            if (relocations) generator.recordRelocations(&parts[s].relocations);
+            // У OVR адреса участков перекрываются: строки и серии не пишутся
+            if (!sections[s].attributes.overlay) {
+                if (lines) generator.recordLines(&parts[s].lines);
+                if (fills) generator.recordFills(&parts[s].fills);
+            }
+            try {
+                generator.generateSection(program, static_cast<uint32_t>(s), parts[s].words);
+            }
+            catch (...) {
+                parts[s].error = std::current_exception();
+            }
+        }
+    };
+    size_t busy = std::count_if(sections.begin(), sections.end(),
+                                [](const SectionLayout::Section& section) { return section.size != 0; });
+    unsigned budget = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t workers = std::min<size_t>(busy, budget);
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < workers; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+    for (const auto& part : parts) {
+        if (part.error) std::rethrow_exception(part.error);
+    }
+
+    // Образ: разделы по базам (по возрастанию), промежутки выравнивания — нули
+    size_t end = 0;
+    for (const auto& section : sections) end = std::max<size_t>(end, section.base + section.size);
+    out.assign((end + 1) / 2, 0);
+    for (size_t s = 0; s < sections.size(); s++) {
+        const Part& part = parts[s];
+        std::copy(part.words.begin(), part.words.end(), out.begin() + sections[s].base / 2);
+        if (instructions) instructions->insert(instructions->end(), part.instructions.begin(), part.instructions.end());
+        if (fills) fills->insert(fills->end(), part.fills.begin(), part.fills.end());
+        if (relocations) relocations->insert(relocations->end(), part.relocations.begin(), part.relocations.end());
+        if (lines) {
+            const auto& rows = part.lines.rows();
+            for (size_t i = 0; i < rows.size(); i++) {
+                uint16_t rowEnd = i + 1 < rows.size() ? rows[i + 1].address : part.lines.endAddress();
+                if (rows[i].line) lines->add(rows[i].address, rowEnd, rows[i].line);
+            }
+        }
+    }
+}
+
+// Новый блок: таблица прошлого блока сбрасывается, адреса его n$ считаются
+// заранее по раскладке SymbolTable::nextAddress (ссылки бывают вперёд).
+// Блок кончается перед обычной меткой, .PSECT или концом участка
+void CodeGenerator::beginBlock(const Program& program, size_t first, size_t last) {
+    for (uint16_t n : localDefined) localAddresses[n] = NO_ADDRESS;
+    localDefined.clear();
+
+    uint16_t address = current_pc;
+    size_t i = first;
+    for (; i < last; i++) {
+        const ASTNode& node = *program.statements[i];
+        auto label = dynamic_cast<const Label*>(&node);
+        if (label && !label->local && i != first) break;
+        auto dir = dynamic_cast<const Directive*>(label ? label->statement.get() : &node);
+        if (dir && dir->type == Directive::Type::PSECT && i != first) break;
+        if (label && label->local) {
+            if (label->local >= localAddresses.size()) localAddresses.resize(label->local + 1, NO_ADDRESS);
+            if (localAddresses[label->local] != NO_ADDRESS) {
+                throw AssemblyError(label->range(), "Duplicate local label " + label->name);
+            }
+            localAddresses[label->local] = address;
+            localDefined.push_back(label->local);
+        }
+        address = SymbolTable::nextAddress(node, address);
     }
+    blockEnd = i;
+}
+
+uint16_t CodeGenerator::resolve(const std::string& label, uint16_t local) const {
+    if (!local) return symtab.resolve(label);
+    if (local >= localAddresses.size() || localAddresses[local] == NO_ADDRESS) {
+        throw std::runtime_error("Undefined local label: " + label + " (not in this block)");
+    }
+    return static_cast<uint16_t>(localAddresses[local]);
 }
 
 void CodeGenerator::visit(const Label& label) {
+    if (!label.local) current_block = label.name;
     if (label.statement) {
         label.statement->accept(*this);
     }
 }
 
 void CodeGenerator::visit(const Instruction& instr) {
+    uint16_t address = current_pc;
     encodeInstruction(instr);
+
+    if (instructions) {
+        EncodedInstruction info;
+        info.address = address;
+        info.type = instr.type;
+        // У JSR в src и у RTS в dst лежит регистр связи, а не операнд
+        if (instr.src && instr.type != Instruction::Type::JSR) {
+            info.srcMode = static_cast<uint8_t>(encodeOperand(*instr.src));
+        }
+        if (instr.dst && instr.type != Instruction::Type::RTS) {
+            info.dstMode = static_cast<uint8_t>(encodeOperand(*instr.dst));
+        }
+        info.words = static_cast<uint8_t>((current_pc - address) / 2);
+        info.block = current_block;
+        instructions->push_back(std::move(info));
+    }
+    if (lines) lines->add(address, current_pc, instr.line);
+    PDP11_PROBE3(statement_encoded, instr.line, address, (current_pc - address) / 2);
 }
 void CodeGenerator::encodeInstruction(const Instruction& instr) {
-    uint16_t opcode = 0;
-    
-    // Определяем опкод
+    // Правила кодирования — isa.hpp, общие с constexpr_asm.hpp
+    if (instr.dst && instr.type != Instruction::Type::RTS) {
+        if (const char* error = isa::destinationError(instr.type, instr.dst->mode)) throw std::runtime_error(error);
+    }
+
+    // Особые форматы
     switch (instr.type) {
-        
-        // Двухоперандные инструкции
-        case Instruction::Type::MOV: opcode = 0010000; break;  // MOV src,dst
-        case Instruction::Type::CMP: opcode = 0020000; break;  // CMP src,dst
-        case Instruction::Type::ADD: opcode = 060000; break;  // ADD src,dst
-        case Instruction::Type::SUB: opcode = 0160000; break;  // SUB src,dst
-        
-        // Однооперандные инструкции
+        // JSR имеет особый формат: JSR R,dst
         case Instruction::Type::JSR: 
-            opcode = 0004000; 
-            // JSR имеет особый формат: JSR R,dst
-            emit(opcode | (encodeRegister(instr.src->reg) << 6) | encodeOperand(*instr.dst, false));
-            if (instr.dst->mode == AddrMode::RELATIVE || 
-                instr.dst->mode == AddrMode::ABSOLUTE) {
-                emit(instr.dst->value);
-            }
+            emit(isa::instructionWord(instr.type, encodeRegister(instr.src->reg), encodeOperand(*instr.dst)));
+            emitExtension(*instr.dst, instr.line);
             return;
-            
-        case Instruction::Type::CLR: opcode = 0005000; break;  // CLR dst
-        case Instruction::Type::COM: opcode = 0005100; break;  // COM dst
-        case Instruction::Type::INC: opcode = 0005200; break;  // INC dst
-        case Instruction::Type::DEC: opcode = 0005300; break;  // DEC dst
-        case Instruction::Type::NEG: opcode = 0005400; break;  // NEG dst
 
         // Инструкции без операндов
         case Instruction::Type::RTS:
-            emit(0000200 | encodeRegister(instr.dst->reg));
+            emit(isa::instructionWord(instr.type, 0, encodeRegister(instr.dst->reg)));
             return;
-        case Instruction::Type::HALT: emit(0000000); return;  // HALT
-        case Instruction::Type::JMP: opcode = 0000100; break;  // JMP dst
+        case Instruction::Type::HALT: emit(isa::instructionWord(instr.type, 0, 0)); return;  // HALT
         
         default:
-            throw std::runtime_error("Unsupported instruction");
+            break;
     }
 
+#ifdef PDP11_DEBUG
     printf("=== DEBUG ===\n");
-    printf("Opcode: %06o (oct) = %04X (hex)\n", opcode, opcode);
+    printf("Opcode: %06o (oct) = %04X (hex)\n", isa::baseOpcode(instr.type), isa::baseOpcode(instr.type));
+#endif
     
-    // Кодируем операнды для обычных инструкций
+    // Кодируем операнды: каждый режим кодируется один раз
     uint16_t src_mode = 0;
-        if (instr.src) {
-        src_mode = encodeOperand(*instr.src, true);
+    if (instr.src) {
+        src_mode = encodeOperand(*instr.src);
+#ifdef PDP11_DEBUG
         printf("Src mode: %03o (oct) = %02X (hex)\n", src_mode, src_mode);
+#endif
     }
     uint16_t dst_mode = 0;
-        if (instr.dst) {
-        dst_mode = encodeOperand(*instr.dst, false);
-        printf("Dst mode: %03o (oct) = %02X (hex)\n", dst_mode, dst_mode);
-    }
-
-    if (instr.src && instr.type != Instruction::Type::JMP) {
-        src_mode = encodeOperand(*instr.src, true);
-    }
-    
     if (instr.dst) {
-        dst_mode = encodeOperand(*instr.dst, false);
-    }
-    
-    // Особый случай для JMP
-    if (instr.type == Instruction::Type::JMP) {
-        if (!instr.dst) throw std::runtime_error("JMP requires destination");
-        emit(opcode | encodeOperand(*instr.dst, false));
-        
-        if (instr.dst->mode == AddrMode::RELATIVE || 
-            instr.dst->mode == AddrMode::ABSOLUTE) {
-            emit(instr.dst->value);
-        }
-        return;
+        dst_mode = encodeOperand(*instr.dst);
+#ifdef PDP11_DEBUG
+        printf("Dst mode: %03o (oct) = %02X (hex)\n", dst_mode, dst_mode);
+#endif
     }
     
-    uint16_t word = opcode | (src_mode * 0100) | dst_mode; 
+    uint16_t word = isa::instructionWord(instr.type, src_mode, dst_mode);
+#ifdef PDP11_DEBUG
     printf("Final word: %06o (oct) = %04X (hex)\n", word, word);
+#endif
     emit(word);
 
-    // Дополнительные слова для некоторых режимов адресации
-    if (instr.src && (instr.src->mode == AddrMode::IMMEDIATE || 
-                      instr.src->mode == AddrMode::ABSOLUTE ||
-                      instr.src->mode == AddrMode::RELATIVE ||
-                      instr.src->mode == AddrMode::INDEXED)) {
-        emit(instr.src->value);
-    }
-    
-    if (instr.dst && (instr.dst->mode == AddrMode::IMMEDIATE || 
-                      instr.dst->mode == AddrMode::ABSOLUTE ||
-                      instr.dst->mode == AddrMode::RELATIVE ||
-                      instr.dst->mode == AddrMode::INDEXED)) {
-        emit(instr.dst->value);
+    // Дополнительные слова: сначала src, затем dst (порядок выборки процессором)
+    if (instr.src) emitExtension(*instr.src, instr.line);
+    if (instr.dst) emitExtension(*instr.dst, instr.line);
+}
+
+// Дополнительное слово операнда (для режимов 27, 37, 67, 77 и 6R).
+// Относительные режимы хранят смещение от адреса следующего слова.
+void CodeGenerator::emitExtension(const Operand& op, size_t line) {
+    AddrMode mode = addressMode(op);
+    if (isa::extensionWords(mode) == 0) return;
+    uint16_t value = op.label.empty() ? static_cast<uint16_t>(op.value) : resolve(op.label, op.local);
+    // Адрес метки в смещении X(Rn) не сделать относительным
+    if (mode == AddrMode::INDEXED && relocations && imageAddress(op.label, op.local)) {
+        relocations->push_back({current_pc, line, Relocation::Kind::INDEX});
     }
+    emit(isa::extensionWord(mode, value, static_cast<uint16_t>(current_pc + 2)));
+}
 
+uint16_t CodeGenerator::encodeOperand(const Operand& op) {
+    // Режимы через PC регистр не используют
+    bool usesReg = !op.reg.empty();
+    return isa::operandField(addressMode(op), usesReg ? encodeRegister(op.reg) : 7);
 }
 
-uint16_t CodeGenerator::encodeOperand(const Operand& op, bool is_src) {
-    uint16_t encoded = 0;
-    
-    switch (op.mode) {
-        case AddrMode::REGISTER:
-            encoded = encodeRegister(op.reg);
-            break;
-        case AddrMode::IMMEDIATE:
-            encoded = 027; // #n
-            if (!is_src) throw std::runtime_error("Immediate mode not allowed for destination");
-            break;
-        case AddrMode::RELATIVE:
-            encoded = 067; // address
-            break;
-        case AddrMode::ABSOLUTE:
-            encoded = 037; // @#address
-            break;
-        case AddrMode::REG_DEF:
-            encoded = 010 | encodeRegister(op.reg);
-            break;
-        case AddrMode::AUTOINC:
-            encoded = 020 | encodeRegister(op.reg);
-            break;
-        case AddrMode::AUTODEC:
-            encoded = 030 | encodeRegister(op.reg);
-            break;
-        case AddrMode::INDEXED:
-            encoded = 060 | encodeRegister(op.reg);
-            emit(op.value); // Дополнительное слово
-            break;
-        default:
-            throw std::runtime_error("Unknown addressing mode");
+// Метка образа: обычная метка программы или локальная n$
+bool CodeGenerator::imageAddress(const std::string& label, uint16_t local) const {
+    return local != 0 || (!label.empty() && symtab.isAddress(label));
+}
+
+// Режим, в котором кодируется операнд. С --pic относительный операнд с
+// постоянным адресом (число, .EQU, --define, импорт) становится @#адрес:
+// смещение от PC указывало бы мимо после переноса образа. Длина та же.
+// У @адрес такой замены нет: @#адрес снимает одну косвенность
+AddrMode CodeGenerator::addressMode(const Operand& op) const {
+    if (relocations && op.mode == AddrMode::RELATIVE && !imageAddress(op.label, op.local)) {
+        return AddrMode::ABSOLUTE;
     }
-    
-    return encoded;
+    if (relocations && op.mode == AddrMode::RELATIVE_DEF && !imageAddress(op.label, op.local)) {
+        throw std::runtime_error("@" + (op.label.empty() ? std::to_string(op.value) : op.label) +
+                                 " is not position-independent: the pointer is at a fixed address");
+    }
+    return op.mode;
 }
 
 uint16_t CodeGenerator::encodeRegister(const std::string& reg) {
-    if (reg == "PC") return 07;
-    if (reg == "SP") return 06;
-    if (reg[0] == 'R' && reg.size() == 2 && isdigit(reg[1])) {
-        return reg[1] - '0';
+    int number = isa::registerNumber(reg);
+    if (number < 0) {
+        throw std::runtime_error("Invalid register: " + reg);
     }
-    throw std::runtime_error("Invalid register: " + reg);
+    return static_cast<uint16_t>(number);
 }
 
 void CodeGenerator::visit(const Directive& dir) {
-    switch (dir.type) {
-        case Directive::Type::WORD:
-            for (const auto& op : dir.operands) {
-                emit(op->value);
-            }
-            break;
-        case Directive::Type::BYTE:
-            for (const auto& op : dir.operands) {
-                emit(op->value & 0xFF);
-                if (dir.operands.size() % 2 != 0) {
-                    emit(0); // Выравнивание
-                }
-            }
-            break;
-        case Directive::Type::ASCII:
-            for (const auto& op : dir.operands) {
-                emit(static_cast<uint16_t>(op->value) & 0xFF);
-            }
-            break;
-        default:
-            break;
+    uint16_t address = current_pc;
+    if (dir.type == Directive::Type::EVEN || dir.type == Directive::Type::ODD) {
+        // Пропущенный байт нулевой: половина слова уже заполнена нулём,
+        // а для .ODD добавляется нулевое слово
+        current_pc = SymbolTable::nextAddress(dir, current_pc);
+        if ((current_pc & 1) && !halfWord) output.push_back(0);
+        halfWord = current_pc & 1;
+        return;
     }
+    if (!dir.isData()) return;
+
+    // Образ директивы копируется целиком: байты блоком, затем заполнение
+    // (.FILL/.BLKB/.BLKW) или файл (.INCBIN), затем в готовые слова
+    // подставляются адреса меток. Запись побайтовая: директива может
+    // начинаться с нечётного адреса, во второй половине уже начатого слова.
+    // Слова PDP-11 little-endian, как и на хосте (см. Emulator)
+    size_t size = dir.imageSize();
+    size_t position = 2 * output.size() - (halfWord ? 1 : 0);
+    // Раскладка (SymbolTable::advance) такой оператор уже отвергла; без
+    // неё переполнение не должно стать выделением гигабайтов
+    if (position + size > isa::ADDRESS_SPACE) {
+        throw AssemblyError(dir.range(), "Address overflow: data past 0177777");
+    }
+    output.resize((position + size + 1) / 2);
+    auto* image = reinterpret_cast<uint8_t*>(output.data()) + position;
+
+    std::memcpy(image, dir.data.data(), dir.data.size());
+    uint8_t* fill = image + dir.data.size();
+    if (dir.fillPattern == 0 || !dir.isWordData()) {
+        std::memset(fill, dir.fillPattern & 0xFF, dir.fillBytes);
+    } else {
+        std::fill_n(reinterpret_cast<uint16_t*>(fill), dir.fillBytes / 2, dir.fillPattern);
+    }
+    if (fills && dir.fillBytes > 0) {
+        // Только целые слова серии (.BLKB может начинаться с нечётного адреса)
+        size_t begin = (address + dir.data.size() + 1) & ~size_t(1);
+        size_t end = (address + dir.data.size() + dir.fillBytes) & ~size_t(1);
+        if (end > begin) {
+            fills->push_back({static_cast<uint16_t>(begin), static_cast<uint32_t>((end - begin) / 2),
+                              dir.fillPattern});
+        }
+    }
+    copyIncbin(dir, fill + dir.fillBytes);
+    for (const auto& fixup : dir.fixups) {
+        uint16_t value = resolve(fixup.label, fixup.local);
+        std::memcpy(image + fixup.offset, &value, sizeof(value));
+        if (relocations && imageAddress(fixup.label, fixup.local)) {
+            relocations->push_back({static_cast<uint16_t>(address + fixup.offset), dir.line,
+                                    Relocation::Kind::DATA});
+        }
+    }
+
+    current_pc = static_cast<uint16_t>(current_pc + size);
+    halfWord = (position + size) & 1;
+    if (lines) lines->add(address, current_pc, dir.line);
+    PDP11_PROBE3(statement_encoded, dir.line, address, (size + 1) / 2);
 }
 
 void CodeGenerator::visit(const Operand& op) {
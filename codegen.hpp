@@ -3,15 +3,69 @@
 
 #include "ast.hpp"
 #include "symtab.hpp"
+#include "linetable.hpp"
 #include <vector>
 #include <cstdint>
 #include <stdexcept>
 
+// Сведения о закодированной команде (оценка времени, статистика)
+struct EncodedInstruction {
+    static constexpr uint8_t NO_OPERAND = 0377;
+
+    uint16_t address;
+    Instruction::Type type;
+    uint8_t srcMode = NO_OPERAND; // 6-битный код режима (режим << 3 | регистр)
+    uint8_t dstMode = NO_OPERAND;
+    uint8_t words;                // Длина вместе с дополнительными словами
+    std::string block;            // Ближайшая метка выше команды
+};
+
+// Серия одинаковых слов из .FILL/.BLKB/.BLKW (для сжатия образа)
+struct FillRun {
+    uint16_t address; // Байтовый адрес первого слова
+    uint32_t words;
+    uint16_t pattern;
+};
+
+// Слово образа с адресом метки: если образ загружен не с адреса 0,
+// к слову прибавляется адрес загрузки (--pic)
+struct Relocation {
+    enum class Kind : uint8_t {
+        DATA,  // .WORD метка
+        INDEX  // Смещение метка(Rn)
+    };
+    uint16_t address; // Байтовый адрес слова
+    size_t line;
+    Kind kind;
+};
+
 class CodeGenerator : public ASTVisitor {
 public:
     explicit CodeGenerator(SymbolTable& symtab) : symtab(symtab) {}
     
-    std::vector<uint16_t> generate(Program& program);
+    std::vector<uint16_t> generate(const Program& program);
+    // Генерация в переданный буфер (ёмкость буфера переиспользуется).
+    // Несколько разделов (.PSECT) кодируются параллельно, каждый в свой
+    // буфер, и копируются в образ по базам из SymbolTable::sections()
+    void generate(const Program& program, std::vector<uint16_t>& out);
+
+    // Если задано, каждая закодированная команда описывается в out
+    void recordInstructions(std::vector<EncodedInstruction>* out) { instructions = out; }
+
+    // Если задано, в out пишутся строки исходника для каждого диапазона слов
+    void recordLines(LineTable* out) { lines = out; }
+
+    // Если задано, в out пишутся серии заполнения (по возрастанию адресов)
+    void recordFills(std::vector<FillRun>* out) { fills = out; }
+
+    // Если задано — позиционно-независимый код: ссылки на метки образа
+    // относительные (67), на постоянные адреса — абсолютные @# (37);
+    // слова, которые так не кодируются, пишутся в out по возрастанию адресов
+    void recordRelocations(std::vector<Relocation>* out) { relocations = out; }
+
+    // Сколько потоков (вместе с вызывающим) может занять кодирование
+    // разделов; 0 — по числу ядер. Вызов из пула потоков передаёт свою долю
+    void setThreads(unsigned count) { threads = count; }
     
     // Visitor методы
     void visit(const Instruction& instr) override;
@@ -23,11 +77,34 @@ public:
 private:
     SymbolTable& symtab;
     std::vector<uint16_t> output;
-    uint16_t current_pc = 0;
+    uint16_t current_pc = 0; // Байтовый адрес следующего байта
+    bool halfWord = false;   // Последнее слово output заполнено наполовину
+    std::vector<EncodedInstruction>* instructions = nullptr;
+    LineTable* lines = nullptr;
+    std::vector<FillRun>* fills = nullptr;
+    std::vector<Relocation>* relocations = nullptr;
+    unsigned threads = 0;
+    std::string current_block;
+
+    // Локальные метки n$ текущего блока (от обычной метки до следующей):
+    // адрес по номеру. Заполняется при входе в блок и сбрасывается при выходе
+    static constexpr uint32_t NO_ADDRESS = 0xFFFFFFFF;
+    std::vector<uint32_t> localAddresses;
+    std::vector<uint16_t> localDefined; // Заданные номера (для сброса)
+    size_t blockEnd = 0;                // Первый оператор следующего блока
+
+    void generateRun(const Program& program, size_t first, size_t last);
+    void generateSection(const Program& program, uint32_t section, std::vector<uint16_t>& out);
+    void generateSections(const Program& program, std::vector<uint16_t>& out);
+    void beginBlock(const Program& program, size_t first, size_t last);
+    uint16_t resolve(const std::string& label, uint16_t local) const;
+    bool imageAddress(const std::string& label, uint16_t local) const;
+    AddrMode addressMode(const Operand& op) const;
     
     void emit(uint16_t word);
     void encodeInstruction(const Instruction& instr);
-    uint16_t encodeOperand(const Operand& op, bool is_src);
+    uint16_t encodeOperand(const Operand& op);
+    void emitExtension(const Operand& op, size_t line);
     uint16_t encodeRegister(const std::string& reg);
 };
 
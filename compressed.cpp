@@ -0,0 +1,242 @@
+#include "compressed.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr uint16_t FORMAT_VERSION = 1;
+static constexpr size_t HEADER_SIZE = 8;
+
+static constexpr uint16_t LITERAL = 0000000;
+static constexpr uint16_t RUN = 0040000;
+static constexpr uint16_t MATCH = 0100000;
+static constexpr size_t MAX_COUNT = 037777;
+
+// Короче двух слов токена не окупаются
+static constexpr size_t MIN_RUN = 3;
+static constexpr size_t MIN_MATCH = 3;
+static constexpr int HASH_BITS = 14;
+
+namespace {
+
+uint32_t hash3(const uint16_t* p) {
+    uint32_t v = p[0] | (static_cast<uint32_t>(p[1]) << 16);
+    v ^= p[2] * 0x9E3779B1u;
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void putU16(std::string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>(v >> 8));
+}
+
+uint16_t getU16(std::string_view bytes, size_t pos) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(bytes[pos]) | (static_cast<uint8_t>(bytes[pos + 1]) << 8));
+}
+
+// Заголовок "P11Z": возвращает длину образа в словах
+size_t checkHeader(std::string_view bytes) {
+    if (bytes.size() < HEADER_SIZE || bytes.substr(0, 4) != "P11Z" || bytes.size() % 2 != 0) {
+        throw std::runtime_error("not a compressed image");
+    }
+    if (getU16(bytes, 4) != FORMAT_VERSION) throw std::runtime_error("unsupported compressed image version");
+    return getU16(bytes, 6);
+}
+
+} // namespace
+
+// ========================================================
+// 1. Сжатие
+// ========================================================
+std::string CompressedImage::encode(const std::vector<uint16_t>& image, const std::vector<FillRun>& fills) {
+    const size_t n = image.size();
+    if (n > 0xFFFF) throw std::runtime_error("image too large to compress");
+
+    std::vector<uint16_t> tokens;
+    tokens.reserve(n / 4 + 16);
+
+    size_t literalStart = 0;
+    auto flushLiterals = [&](size_t end) {
+        while (literalStart < end) {
+            size_t count = std::min(end - literalStart, MAX_COUNT);
+            tokens.push_back(static_cast<uint16_t>(LITERAL | count));
+            tokens.insert(tokens.end(), image.begin() + literalStart, image.begin() + literalStart + count);
+            literalStart += count;
+        }
+    };
+
+    // Длина серии с позиции p. Внутри серии .FILL/.BLKW слова заведомо
+    // равны, поэтому конец ищется прыжком, а не сравнением
+    size_t nextFill = 0;
+    auto runLength = [&](size_t p) {
+        size_t end = p + 1;
+        while (end < n) {
+            while (nextFill < fills.size() && fills[nextFill].address / 2 + fills[nextFill].words <= end) {
+                nextFill++;
+            }
+            if (nextFill < fills.size()) {
+                size_t begin = fills[nextFill].address / 2;
+                if (begin <= end && image[begin] == image[p]) {
+                    end = std::min<size_t>(begin + fills[nextFill].words, n);
+                    continue;
+                }
+            }
+            if (image[end] != image[p]) break;
+            end++;
+        }
+        return end - p;
+    };
+
+    // Последняя позиция (+1) с таким хешем трёх слов
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+
+    size_t p = 0;
+    while (p < n) {
+        size_t run = runLength(p);
+        if (run >= MIN_RUN) {
+            flushLiterals(p);
+            for (size_t left = run; left > 0;) {
+                size_t count = std::min(left, MAX_COUNT);
+                tokens.push_back(static_cast<uint16_t>(RUN | count));
+                tokens.push_back(image[p]);
+                left -= count;
+            }
+            p += run;
+            literalStart = p;
+            continue;
+        }
+
+        if (p + MIN_MATCH <= n) {
+            uint32_t& slot = table[hash3(&image[p])];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(p + 1);
+            if (candidate) {
+                size_t from = candidate - 1;
+                size_t length = 0;
+                while (p + length < n && length < MAX_COUNT && image[from + length] == image[p + length]) length++;
+                if (length >= MIN_MATCH) {
+                    flushLiterals(p);
+                    tokens.push_back(static_cast<uint16_t>(MATCH | length));
+                    tokens.push_back(static_cast<uint16_t>(p - from));
+                    for (size_t k = p + 1; k < p + length && k + MIN_MATCH <= n; k++) {
+                        table[hash3(&image[k])] = static_cast<uint32_t>(k + 1);
+                    }
+                    p += length;
+                    literalStart = p;
+                    continue;
+                }
+            }
+        }
+        p++;
+    }
+    flushLiterals(n);
+    tokens.push_back(0);
+
+    std::string out = "P11Z";
+    out.reserve(HEADER_SIZE + 2 * tokens.size());
+    putU16(out, FORMAT_VERSION);
+    putU16(out, static_cast<uint16_t>(n));
+    for (uint16_t word : tokens) putU16(out, word);
+    return out;
+}
+
+// ========================================================
+// 2. Распаковка
+// ========================================================
+std::vector<uint16_t> CompressedImage::decode(std::string_view bytes) {
+    const size_t n = checkHeader(bytes);
+    std::vector<uint16_t> image;
+    image.reserve(n);
+
+    size_t pos = HEADER_SIZE;
+    auto next = [&] {
+        if (pos + 2 > bytes.size()) throw std::runtime_error("truncated compressed image");
+        uint16_t word = getU16(bytes, pos);
+        pos += 2;
+        return word;
+    };
+
+    for (uint16_t token; (token = next()) != 0;) {
+        size_t count = token & MAX_COUNT;
+        if (count == 0 || image.size() + count > n) throw std::runtime_error("corrupt compressed image");
+        switch (token & ~MAX_COUNT) {
+            case LITERAL:
+                for (size_t i = 0; i < count; i++) image.push_back(next());
+                break;
+            case RUN:
+                image.insert(image.end(), count, next());
+                break;
+            case MATCH: {
+                size_t distance = next();
+                if (distance == 0 || distance > image.size()) throw std::runtime_error("corrupt compressed image");
+                // По слову: источник может перекрываться с приёмником
+                for (size_t from = image.size() - distance; count > 0; count--) image.push_back(image[from++]);
+                break;
+            }
+            default:
+                throw std::runtime_error("corrupt compressed image");
+        }
+    }
+    if (image.size() != n) throw std::runtime_error("truncated compressed image");
+    return image;
+}
+
+// ========================================================
+// 3. Загрузчик для PDP-11
+// ========================================================
+// Позиционно-независимая часть (с BODY) работает после переноса под TOP.
+// Регистры: R1 — поток, R2 — приёмник, R3 — счётчик, R0/R4/R5 — рабочие
+static constexpr uint16_t TOP = 0160000; // Начало страницы ввода-вывода
+static constexpr size_t BODY = 12;       // Индекс слова метки body
+static constexpr size_t STREAM = 49;     // Поток начинается сразу за загрузчиком
+
+static constexpr uint16_t LOADER[STREAM] = {
+    0010701,           //  0        MOV PC,R1
+    0062701, 0,        //  1        ADD #<всего-2>,R1       ; R1 = конец потока
+    0012702, TOP,      //  3        MOV #TOP,R2
+    0012703, 0,        //  5        MOV #<всего/2>,R3
+    0014142,           //  7 copy:  MOV -(R1),-(R2)
+    0077302,           //  8        SOB R3,copy
+    0062702, 2 * BODY, //  9        ADD #body,R2
+    0000112,           // 11        JMP (R2)
+    0010701,           // 12 body:  MOV PC,R1
+    0062701, 2 * (STREAM - BODY - 1), // ADD #<stream-.>,R1
+    0005002,           // 15        CLR R2
+    0012100,           // 16 loop:  MOV (R1)+,R0
+    0001427,           // 17        BEQ done
+    0010003,           // 18        MOV R0,R3
+    0042703, 0140000,  // 19        BIC #140000,R3          ; число слов
+    0042700, 0037777,  // 21        BIC #037777,R0          ; вид токена
+    0001416,           // 23        BEQ literal
+    0020027, 0040000,  // 24        CMP R0,#040000
+    0001407,           // 26        BEQ run
+    0012104,           // 27        MOV (R1)+,R4            ; MATCH
+    0006304,           // 28        ASL R4
+    0010205,           // 29        MOV R2,R5
+    0160405,           // 30        SUB R4,R5
+    0012522,           // 31 mcopy: MOV (R5)+,(R2)+
+    0077302,           // 32        SOB R3,mcopy
+    0000756,           // 33        BR loop
+    0012104,           // 34 run:   MOV (R1)+,R4
+    0010422,           // 35 rfill: MOV R4,(R2)+
+    0077302,           // 36        SOB R3,rfill
+    0000752,           // 37        BR loop
+    0012122,           // 38 literal: MOV (R1)+,(R2)+
+    0077302,           // 39        SOB R3,literal
+    0000747,           // 40        BR loop
+    0005000, 0005001, 0005002, 0005003, 0005004, 0005005, // 41 done: CLR R0-R5
+    0000137, 0,        // 47        JMP @#0
+};
+
+std::vector<uint16_t> CompressedImage::withLoader(std::string_view compressed) {
+    const size_t n = checkHeader(compressed);
+    size_t streamWords = (compressed.size() - HEADER_SIZE) / 2;
+    size_t total = 2 * (STREAM + streamWords);
+    // Распакованный образ не должен дойти до перенесённого загрузчика
+    if (2 * n + total > TOP) throw std::runtime_error("image too large for the loader");
+
+    std::vector<uint16_t> image(LOADER, LOADER + STREAM);
+    image[2] = static_cast<uint16_t>(total - 2);
+    image[6] = static_cast<uint16_t>(total / 2);
+    for (size_t pos = HEADER_SIZE; pos < compressed.size(); pos += 2) image.push_back(getU16(compressed, pos));
+    return image;
+}
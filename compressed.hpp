@@ -0,0 +1,37 @@
+#ifndef PDP11_COMPRESSED_HPP
+#define PDP11_COMPRESSED_HPP
+
+#include "codegen.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// ========================================================
+// Сжатый образ: серии одинаковых слов + LZ по словам
+// ========================================================
+// Формат "P11Z" (числа — uint16, little-endian):
+//   "P11Z" [версия] [длина образа в словах], затем поток слов-токенов.
+// Токен — слово: биты 15-14 — вид, биты 13-0 — число слов (1-16383):
+//   00 LITERAL — далее столько же слов как есть
+//   01 RUN     — далее одно слово, повторить
+//   10 MATCH   — далее расстояние назад в словах, скопировать уже
+//                распакованное (участки могут перекрываться)
+//   слово 0    — конец потока
+// Всё выровнено на слово, поэтому распаковщик на самой PDP-11 читает
+// поток обычными MOV (R1)+ (см. withLoader).
+class CompressedImage {
+public:
+    // Серии .FILL/.BLKW из CodeGenerator::recordFills позволяют не
+    // сравнивать слова внутри них; результат тот же, что и без них
+    static std::string encode(const std::vector<uint16_t>& image, const std::vector<FillRun>& fills = {});
+
+    static std::vector<uint16_t> decode(std::string_view bytes);
+
+    // Самораспаковывающийся образ: загрузчик с адреса 0 переносит себя
+    // с потоком под страницу ввода-вывода, распаковывает образ с адреса 0
+    // и передаёт ему управление (JMP @#0, R0-R5 обнулены)
+    static std::vector<uint16_t> withLoader(std::string_view compressed);
+};
+
+#endif // PDP11_COMPRESSED_HPP
@@ -0,0 +1,506 @@
+#ifndef PDP11_CONSTEXPR_ASM_HPP
+#define PDP11_CONSTEXPR_ASM_HPP
+
+// ========================================================
+// Ассемблер PDP-11 времени компиляции (C++20)
+// ========================================================
+//   constexpr auto img = pdp11::assemble<"MOV #42,R1\nHALT">();
+//   using namespace pdp11::literals;
+//   constexpr auto img2 = "MOV #42,R1\nHALT"_pdp11;
+//
+// Результат — std::array<uint16_t, N> точного размера. Всё кодирование
+// общее с CodeGenerator и берётся из isa.hpp: режим операнда-метки
+// (labelMode), поле операнда, слово команды, допустимость приёмника и
+// дополнительные слова; числовые литералы — из literal.hpp. Свои здесь
+// только разбор строки и таблица символов: Lexer/Parser строят AST в
+// динамической памяти (unique_ptr, виртуальный обход) и в constexpr не
+// работают. Образ совпадает с Assembler::assemble на том же тексте
+// (проверяется в tests/constexpr_asm_test.cpp).
+//
+// Язык — подмножество Lexer/Parser:
+//   команды  MOV CMP ADD SUB JSR RTS HALT CLR COM INC DEC NEG JMP;
+//   операнды Rn, (Rn), (Rn)+, -(Rn), #n, #-n, @#n, метка, @метка (77), X(Rn);
+//   данные   .WORD (числа, -n и метки), .BYTE, .ASCII, .ASCIZ, .BLKB,
+//            .BLKW, .FILL, .EVEN, .ODD;
+//   прочее   .EQU, .RADIX, .END, обычные метки "имя:".
+// Нет: .IF/.IFF/.IFT/.IFTF/.ENDC, локальных меток n$, .PSECT/.CSECT,
+// .INCBIN и относительного операнда-числа (MOV 1000,R0) — на них
+// ошибка компиляции. Обратное отличие: имена команд (SUB:) здесь
+// допустимы как метки, Lexer их не пропускает. Значение .WORD/.BYTE/#n
+// вне разрядности здесь ошибка, Parser его усекает с предупреждением.
+// Работает без динамической памяти: символы хранятся в массиве
+// фиксированного размера, строки — string_view на исходник.
+// Ошибка в исходнике — ошибка компиляции (throw в consteval).
+
+#include "isa.hpp"
+#include "literal.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace pdp11 {
+
+// Строковый литерал как параметр шаблона
+template <size_t N>
+struct FixedString {
+    char text[N] = {};
+
+    constexpr FixedString(const char (&source)[N]) {
+        for (size_t i = 0; i < N; i++) text[i] = source[i];
+    }
+    constexpr std::string_view view() const { return {text, N - 1}; }
+};
+
+namespace detail {
+
+constexpr size_t MAX_SYMBOLS = 256;
+constexpr size_t MAX_LINE_TOKENS = 64;
+
+struct Token {
+    enum class Kind { IDENT, NUMBER, STRING, PUNCT } kind = Kind::PUNCT;
+    std::string_view text;
+};
+
+struct Operand {
+    AddrMode mode = AddrMode::REGISTER;
+    int reg = 7;
+    int32_t value = 0;
+    std::string_view label;
+};
+
+struct Symbol {
+    std::string_view name;
+    uint16_t value = 0;
+};
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+constexpr bool isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+// Сбой разбора: в consteval превращается в ошибку компиляции
+[[noreturn]] inline void fail(const char* message) {
+    throw message;
+}
+
+constexpr bool findMnemonic(std::string_view name, Instruction::Type& type) {
+    constexpr std::pair<std::string_view, Instruction::Type> table[] = {
+        {"MOV", Instruction::Type::MOV}, {"CMP", Instruction::Type::CMP},
+        {"ADD", Instruction::Type::ADD}, {"SUB", Instruction::Type::SUB},
+        {"JSR", Instruction::Type::JSR}, {"RTS", Instruction::Type::RTS},
+        {"HALT", Instruction::Type::HALT}, {"CLR", Instruction::Type::CLR},
+        {"COM", Instruction::Type::COM}, {"INC", Instruction::Type::INC},
+        {"DEC", Instruction::Type::DEC}, {"NEG", Instruction::Type::NEG},
+        {"JMP", Instruction::Type::JMP}
+    };
+    for (const auto& entry : table) {
+        if (entry.first == name) {
+            type = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Два прохода по исходнику: первый назначает адреса, второй кодирует
+class ConstAssembler {
+public:
+    constexpr ConstAssembler(std::string_view source, uint16_t* out, size_t capacity)
+        : source(source), out(out), capacity(capacity) {}
+
+    // Возвращает число слов образа; при out != nullptr заполняет образ
+    constexpr size_t run() {
+        for (pass = 1; pass <= 2; pass++) {
+            pc = 0;
+            radix = 8;
+            size_t pos = 0;
+            bool ended = false;
+            while (pos < source.size() && !ended) {
+                size_t eol = source.find('\n', pos);
+                if (eol == std::string_view::npos) eol = source.size();
+                ended = assembleLine(source.substr(pos, eol - pos));
+                pos = eol + 1;
+            }
+            if (pass == 1) size = (pc + 1) / 2;
+        }
+        return size;
+    }
+
+private:
+    std::string_view source;
+    uint16_t* out;
+    size_t capacity;
+    int pass = 1;
+    uint16_t pc = 0;
+    size_t size = 0;
+    unsigned radix = 8; // .RADIX
+
+    std::array<Symbol, MAX_SYMBOLS> symbols{};
+    size_t symbolCount = 0;
+
+    std::array<Token, MAX_LINE_TOKENS> tokens{};
+    size_t count = 0;
+    size_t cur = 0;
+
+    // ---------- Лексер строки ----------
+    constexpr void tokenize(std::string_view line) {
+        count = 0;
+        size_t i = 0;
+        while (i < line.size()) {
+            char c = line[i];
+            if (c == ';') break;
+            if (c == ' ' || c == '\t' || c == '\r') {
+                i++;
+                continue;
+            }
+            if (count == MAX_LINE_TOKENS) fail("Too many tokens on one line");
+
+            size_t start = i;
+            Token token;
+            if (isDigit(c)) {
+                // Длина литерала от системы счисления не зависит
+                token.kind = Token::Kind::NUMBER;
+                i += literal::parse(line.substr(i), 10).length;
+            } else if (isAlpha(c) || c == '.') {
+                token.kind = Token::Kind::IDENT;
+                while (i < line.size() && (isAlpha(line[i]) || isDigit(line[i]) || line[i] == '.')) i++;
+            } else if (c == '"') {
+                token.kind = Token::Kind::STRING;
+                size_t close = line.find('"', i + 1);
+                if (close == std::string_view::npos) fail("Unterminated string");
+                start = i + 1;
+                tokens[count++] = {Token::Kind::STRING, line.substr(start, close - start)};
+                i = close + 1;
+                continue;
+            } else {
+                token.kind = Token::Kind::PUNCT;
+                i++;
+            }
+            token.text = line.substr(start, i - start);
+            tokens[count++] = token;
+        }
+        cur = 0;
+    }
+
+    constexpr bool atEnd() const { return cur >= count; }
+    constexpr const Token& peek() const {
+        if (atEnd()) fail("Unexpected end of line");
+        return tokens[cur];
+    }
+    constexpr bool isPunct(char c) const {
+        return !atEnd() && tokens[cur].kind == Token::Kind::PUNCT && tokens[cur].text[0] == c;
+    }
+    constexpr void expectPunct(char c, const char* message) {
+        if (!isPunct(c)) fail(message);
+        cur++;
+    }
+
+    // ---------- Значения и символы ----------
+    // Те же правила, что у Lexer; аргумент .RADIX всегда десятичный
+    constexpr int32_t number(bool radixArgument = false) {
+        const Token& token = peek();
+        if (token.kind != Token::Kind::NUMBER) fail("Expected number");
+        auto result = literal::parse(token.text, radixArgument ? 10 : radix);
+        if (result.status == literal::Status::BAD_DIGIT) fail("Invalid number");
+        if (result.status == literal::Status::OVERFLOW || result.value > 0x7FFFFFFF) {
+            fail("Number out of range");
+        }
+        cur++;
+        return static_cast<int32_t>(result.value);
+    }
+
+    // Значение .WORD/.BYTE/#n с необязательным минусом. Предупреждений
+    // здесь нет, поэтому то, что Parser усёк бы с предупреждением, — ошибка
+    constexpr int32_t value(unsigned bits) {
+        bool negative = isPunct('-');
+        if (negative) cur++;
+        int32_t result = number();
+        if (negative) result = -result;
+        if (!literal::fits(result, bits)) fail("Value out of range");
+        return result;
+    }
+
+    constexpr int registerAt() const {
+        return !atEnd() && tokens[cur].kind == Token::Kind::IDENT ? isa::registerNumber(tokens[cur].text) : -1;
+    }
+
+    constexpr int expectRegister() {
+        int reg = registerAt();
+        if (reg < 0) fail("Expected register");
+        cur++;
+        return reg;
+    }
+
+    constexpr void define(std::string_view name, uint16_t value) {
+        if (pass != 1) return;
+        for (size_t i = 0; i < symbolCount; i++) {
+            if (symbols[i].name == name) fail("Duplicate label");
+        }
+        if (symbolCount == MAX_SYMBOLS) fail("Too many symbols");
+        symbols[symbolCount++] = {name, value};
+    }
+
+    constexpr uint16_t resolve(std::string_view name) const {
+        if (pass == 1) return 0;
+        for (size_t i = 0; i < symbolCount; i++) {
+            if (symbols[i].name == name) return symbols[i].value;
+        }
+        fail("Undefined symbol");
+    }
+
+    // ---------- Вывод ----------
+    // Счётчик адреса байтовый; команды и слова — только с чётного адреса
+    constexpr void emit(uint16_t word) {
+        if (pc & 1) fail("Word at odd address (use .EVEN)");
+        if (pass == 2 && out) {
+            size_t index = pc / 2;
+            if (index >= capacity) fail("Image larger than in the sizing pass");
+            out[index] = word;
+        }
+        pc += 2;
+    }
+
+    // Байты пакуются по два в слово (младший — по чётному адресу)
+    constexpr void emitByte(uint8_t byte) {
+        if (pass == 2 && out) {
+            size_t index = pc / 2;
+            if (index >= capacity) fail("Image larger than in the sizing pass");
+            out[index] = static_cast<uint16_t>((pc & 1) ? (out[index] & 0xFF) | (byte << 8) : byte);
+        }
+        pc++;
+    }
+
+    constexpr void emitExtension(const Operand& op) {
+        if (isa::extensionWords(op.mode) == 0) return;
+        uint16_t value = op.label.empty() ? static_cast<uint16_t>(op.value) : resolve(op.label);
+        emit(isa::extensionWord(op.mode, value, static_cast<uint16_t>(pc + 2)));
+    }
+
+    // ---------- Парсер ----------
+    constexpr Operand operand() {
+        Operand op;
+        if (atEnd()) fail("Expected operand");
+
+        if (isPunct('#')) {
+            cur++;
+            op.mode = AddrMode::IMMEDIATE;
+            op.value = value(16);
+            return op;
+        }
+        if (isPunct('@')) {
+            cur++;
+            if (isPunct('#')) {
+                cur++;
+                op.mode = AddrMode::ABSOLUTE;
+                op.value = number();
+                return op;
+            }
+            if (peek().kind != Token::Kind::IDENT) fail("Expected label after '@'");
+            op.mode = isa::labelMode(true);
+            op.label = tokens[cur++].text;
+            return op;
+        }
+        if (isPunct('(')) {
+            cur++;
+            op.reg = expectRegister();
+            expectPunct(')', "Expected ')' after register");
+            op.mode = AddrMode::REG_DEF;
+            if (isPunct('+')) {
+                cur++;
+                op.mode = AddrMode::AUTOINC;
+            }
+            return op;
+        }
+        if (isPunct('-')) {
+            cur++;
+            expectPunct('(', "Expected '(' after '-'");
+            op.reg = expectRegister();
+            expectPunct(')', "Expected ')' after register");
+            op.mode = AddrMode::AUTODEC;
+            return op;
+        }
+        if (registerAt() >= 0) {
+            op.mode = AddrMode::REGISTER;
+            op.reg = expectRegister();
+            return op;
+        }
+
+        // X(Rn) или label
+        bool isLabel = peek().kind == Token::Kind::IDENT;
+        if (isLabel) {
+            op.label = tokens[cur++].text;
+        } else {
+            op.value = number();
+        }
+        if (!isPunct('(')) {
+            if (!isLabel) fail("Expected '(' after offset in indexed mode");
+            op.mode = isa::labelMode(false);
+            return op;
+        }
+        cur++;
+        op.reg = expectRegister();
+        expectPunct(')', "Expected ')' after register");
+        op.mode = AddrMode::INDEXED;
+        return op;
+    }
+
+    // Приёмник, слово команды и дополнительные слова — по isa.hpp, как
+    // в CodeGenerator; здесь только разбор операндов
+    constexpr Operand destination(Instruction::Type type) {
+        Operand dst = operand();
+        if (const char* error = isa::destinationError(type, dst.mode)) fail(error);
+        return dst;
+    }
+
+    constexpr void instruction(Instruction::Type type) {
+        switch (type) {
+            case Instruction::Type::MOV:
+            case Instruction::Type::CMP:
+            case Instruction::Type::ADD:
+            case Instruction::Type::SUB: {
+                Operand src = operand();
+                expectPunct(',', "Expected ',' between operands");
+                Operand dst = destination(type);
+                emit(isa::instructionWord(type, isa::operandField(src.mode, src.reg),
+                                          isa::operandField(dst.mode, dst.reg)));
+                emitExtension(src);
+                emitExtension(dst);
+                break;
+            }
+            case Instruction::Type::JSR: {
+                int reg = expectRegister();
+                expectPunct(',', "Expected ',' after link register");
+                Operand dst = destination(type);
+                emit(isa::instructionWord(type, static_cast<uint16_t>(reg), isa::operandField(dst.mode, dst.reg)));
+                emitExtension(dst);
+                break;
+            }
+            case Instruction::Type::RTS:
+                emit(isa::instructionWord(type, 0, static_cast<uint16_t>(expectRegister())));
+                break;
+            case Instruction::Type::HALT:
+                emit(isa::instructionWord(type, 0, 0));
+                break;
+            default: {
+                Operand dst = destination(type);
+                emit(isa::instructionWord(type, 0, isa::operandField(dst.mode, dst.reg)));
+                emitExtension(dst);
+                break;
+            }
+        }
+    }
+
+    // Возвращает true на .END
+    constexpr bool directive(std::string_view name) {
+        if (name == ".WORD") {
+            bool first = true;
+            do {
+                if (!first) cur++;
+                first = false;
+                if (peek().kind == Token::Kind::IDENT) emit(resolve(tokens[cur++].text));
+                else emit(static_cast<uint16_t>(value(16)));
+            } while (isPunct(','));
+        } else if (name == ".BYTE") {
+            bool first = true;
+            do {
+                if (!first) cur++;
+                first = false;
+                emitByte(static_cast<uint8_t>(value(8)));
+            } while (isPunct(','));
+        } else if (name == ".ASCII" || name == ".ASCIZ") {
+            if (atEnd() || tokens[cur].kind != Token::Kind::STRING) fail("Expected string");
+            for (char c : tokens[cur++].text) emitByte(static_cast<uint8_t>(c));
+            if (name == ".ASCIZ") emitByte(0);
+        } else if (name == ".BLKB" || name == ".BLKW") {
+            int32_t count = atEnd() ? 1 : number();
+            if (count < 0) fail("Negative block size");
+            for (int32_t i = 0; i < count; i++) {
+                if (name == ".BLKB") emitByte(0);
+                else emit(0);
+            }
+        } else if (name == ".EVEN") {
+            if (pc & 1) emitByte(0);
+        } else if (name == ".ODD") {
+            if (!(pc & 1)) emitByte(0);
+        } else if (name == ".EQU") {
+            if (peek().kind != Token::Kind::IDENT) fail("Expected symbol name for .EQU");
+            std::string_view symbol = tokens[cur++].text;
+            expectPunct(',', "Expected ',' after .EQU symbol");
+            define(symbol, static_cast<uint16_t>(number()));
+        } else if (name == ".FILL") {
+            int32_t fillCount = number();
+            expectPunct(',', "Expected ',' between .FILL count and value");
+            uint16_t value = static_cast<uint16_t>(number());
+            for (int32_t i = 0; i < fillCount; i++) emit(value);
+        } else if (name == ".RADIX") {
+            uint32_t value = atEnd() ? 8 : static_cast<uint32_t>(number(true));
+            if (!literal::validRadix(value)) fail("Invalid .RADIX (expected 2, 8, 10 or 16)");
+            radix = value;
+        } else if (name == ".END") {
+            return true;
+        } else {
+            fail("Unknown directive");
+        }
+        return false;
+    }
+
+    constexpr bool assembleLine(std::string_view line) {
+        tokenize(line);
+        if (atEnd()) return false;
+
+        // Метка
+        if (count >= 2 && tokens[0].kind == Token::Kind::IDENT && registerAt() < 0 &&
+            tokens[1].kind == Token::Kind::PUNCT && tokens[1].text[0] == ':') {
+            define(tokens[0].text, pc);
+            cur = 2;
+            if (atEnd()) return false;
+        }
+
+        const Token& head = peek();
+        if (head.kind != Token::Kind::IDENT) fail("Unexpected token");
+        cur++;
+
+        bool ended = false;
+        Instruction::Type type{};
+        if (findMnemonic(head.text, type)) {
+            instruction(type);
+        } else if (head.text[0] == '.') {
+            ended = directive(head.text);
+        } else {
+            fail("Unexpected token");
+        }
+
+        if (!atEnd()) fail("Unexpected token after statement");
+        return ended;
+    }
+};
+
+} // namespace detail
+
+// Размер образа в словах
+template <FixedString Source>
+consteval size_t imageSize() {
+    detail::ConstAssembler assembler(Source.view(), nullptr, 0);
+    return assembler.run();
+}
+
+template <FixedString Source>
+consteval auto assemble() {
+    constexpr size_t size = imageSize<Source>();
+    std::array<uint16_t, size> image{};
+    detail::ConstAssembler assembler(Source.view(), image.data(), size);
+    assembler.run();
+    return image;
+}
+
+namespace literals {
+
+template <FixedString Source>
+consteval auto operator""_pdp11() {
+    return assemble<Source>();
+}
+
+} // namespace literals
+
+} // namespace pdp11
+
+#endif // PDP11_CONSTEXPR_ASM_HPP
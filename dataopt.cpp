@@ -0,0 +1,263 @@
+#include "dataopt.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+// Адрес метки в items: два байта, старший бит + номер имени
+// (у старшего байта ещё и LABEL_HIGH)
+static constexpr uint32_t LABEL_ITEM = 0x80000000u;
+static constexpr uint32_t LABEL_HIGH = 0x40000000u;
+
+// Часть блока: данные и выравнивание (.EVEN/.ODD)
+static bool isData(const ASTNode* node) {
+    auto dir = dynamic_cast<const Directive*>(node);
+    return dir && (dir->isData() || dir->type == Directive::Type::EVEN || dir->type == Directive::Type::ODD);
+}
+
+// Данные с меткой или без: по ним можно пройти подряд
+static bool isDataStatement(const ASTNode* node) {
+    if (auto label = dynamic_cast<const Label*>(node)) node = label->statement.get();
+    return node && isData(node);
+}
+
+// Адрес метки уходит из операнда: индекс метка(Rn) или косвенный @метка
+static bool escapes(const Operand* op) {
+    return op && !op->label.empty() && (op->mode == AddrMode::INDEXED || op->mode == AddrMode::RELATIVE_DEF);
+}
+
+// .PSECT/.CSECT (и с меткой): конец области локальных меток
+static bool isSection(const ASTNode* node) {
+    if (auto label = dynamic_cast<const Label*>(node)) node = label->statement.get();
+    auto dir = dynamic_cast<const Directive*>(node);
+    return dir && dir->type == Directive::Type::PSECT;
+}
+
+// Команда пишет в приёмник (CMP только читает, JMP/JSR переходят)
+static bool writesDestination(Instruction::Type type) {
+    switch (type) {
+        case Instruction::Type::CMP:
+        case Instruction::Type::JMP:
+        case Instruction::Type::JSR:
+        case Instruction::Type::RTS:
+        case Instruction::Type::HALT:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// FNV-1a по элементам с конца: хеш каждого хвоста получается по пути
+static uint64_t hashStep(uint64_t hash, uint32_t item) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (item >> (8 * i)) & 0xFF;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+
+static uint64_t suffixKey(uint64_t hash, size_t length) {
+    return hashStep(hash, static_cast<uint32_t>(length));
+}
+
+// ========================================================
+// 1. Описание блока
+// ========================================================
+void DataOptimizer::describe(Block& block, const Program& program) {
+    uint16_t address = block.address;
+    for (size_t i = block.first; i < block.last; i++) {
+        const ASTNode* node = program.statements[i].get();
+        if (auto label = dynamic_cast<const Label*>(node)) node = label->statement.get();
+        auto dir = dynamic_cast<const Directive*>(node);
+        if (!dir) continue;
+
+        // Байт выравнивания зависит от чётности адреса блока
+        uint16_t next = SymbolTable::nextAddress(*dir, address);
+        size_t step = static_cast<uint16_t>(next - address);
+        block.bytes += step;
+        address = next;
+        if (!dir->isData()) {
+            block.keepParity = true;
+            block.items.insert(block.items.end(), step, 0);
+            continue;
+        }
+        if (dir->isWordData()) block.keepParity = true;
+        if (dir->type == Directive::Type::BLKB || dir->type == Directive::Type::BLKW) block.unique = true;
+        if (dir->type == Directive::Type::INCBIN) {
+            block.unique = true;
+            continue;
+        }
+
+        // Образ директивы по байтам, как его соберёт CodeGenerator,
+        // но вместо адресов меток — их номера
+        size_t start = block.items.size();
+        block.items.insert(block.items.end(), dir->data.begin(), dir->data.end());
+        for (size_t k = 0; k < dir->fillBytes; k++) {
+            block.items.push_back(k % 2 ? dir->fillPattern >> 8 : dir->fillPattern & 0xFF);
+        }
+        for (const auto& fixup : dir->fixups) {
+            // Одно имя n$ в разных блоках — разные адреса: такой блок не сливается
+            if (fixup.local) block.unique = true;
+            auto id = labelIds.emplace(fixup.label, static_cast<uint32_t>(labelIds.size())).first->second;
+            block.items[start + fixup.offset] = LABEL_ITEM | id;
+            block.items[start + fixup.offset + 1] = LABEL_ITEM | LABEL_HIGH | id;
+        }
+    }
+}
+
+// ========================================================
+// 2. Проход
+// ========================================================
+DataOptimizer::Stats DataOptimizer::run(Program& program) {
+    Stats stats;
+    auto& statements = program.statements;
+    labelIds.clear();
+
+    // Ссылки на метки, метки, в которые пишут, и метки, чей адрес ушёл
+    std::unordered_set<std::string> referenced;
+    std::unordered_set<std::string> written;
+    std::unordered_set<std::string> escaped;
+    for (const auto& stmt : statements) {
+        const ASTNode* node = stmt.get();
+        if (auto label = dynamic_cast<const Label*>(node)) node = label->statement.get();
+
+        if (auto instr = dynamic_cast<const Instruction*>(node)) {
+            if (instr->src && !instr->src->label.empty()) referenced.insert(instr->src->label);
+            if (instr->dst && !instr->dst->label.empty()) {
+                referenced.insert(instr->dst->label);
+                if (writesDestination(instr->type)) written.insert(instr->dst->label);
+            }
+            if (escapes(instr->src.get())) escaped.insert(instr->src->label);
+            if (escapes(instr->dst.get())) escaped.insert(instr->dst->label);
+        }
+        else if (auto dir = dynamic_cast<const Directive*>(node)) {
+            for (const auto& fixup : dir->fixups) {
+                referenced.insert(fixup.label);
+                escaped.insert(fixup.label);
+            }
+        }
+    }
+
+    // Исходные адреса операторов: нужна только чётность
+    std::vector<uint16_t> addresses = SymbolTable::sectionAddresses(program);
+
+    // Блоки: метка с данными (на той же или следующей строке) и
+    // идущие за ней директивы данных без меток
+    // pinnedRun — идут данные вплотную за закреплённым блоком
+    std::vector<Block> blocks;
+    bool pinnedRun = false;
+    for (size_t i = 0; i < statements.size(); i++) {
+        // Локальные метки n$ неуникальны по имени: их данные не трогаем
+        auto label = dynamic_cast<const Label*>(statements[i].get());
+        bool isBlock = label && !label->local;
+        size_t end = i + 1;
+        if (isBlock && !label->statement) {
+            isBlock = end < statements.size() && isData(statements[end].get());
+        } else if (isBlock) {
+            isBlock = isData(label->statement.get());
+        }
+        if (!isBlock) {
+            pinnedRun = pinnedRun && isDataStatement(statements[i].get());
+            continue;
+        }
+        while (end < statements.size() && isData(statements[end].get())) end++;
+
+        Block block;
+        block.first = i;
+        block.last = end;
+        block.label = label->name;
+        block.address = addresses[i];
+        block.pinned = pinnedRun || escaped.count(label->name);
+        pinnedRun = block.pinned;
+        for (size_t j = end; j < statements.size(); j++) {
+            auto next = dynamic_cast<const Label*>(statements[j].get());
+            if ((next && !next->local) || isSection(statements[j].get())) break;
+            if (next) {
+                block.scope = true;
+                break;
+            }
+        }
+        describe(block, program);
+        blocks.push_back(std::move(block));
+        i = end - 1;
+    }
+    stats.blocks = blocks.size();
+
+    std::vector<bool> removed(statements.size(), false);
+    auto remove = [&](const Block& block) {
+        std::fill(removed.begin() + block.first, removed.begin() + block.last, true);
+        stats.bytesSaved += block.bytes;
+    };
+
+    // Убираются только блоки чётной длины: адреса за ними сдвигаются на
+    // чётное число, и команды со словными данными остаются на чётных адресах.
+    // Кандидаты на слияние: длинные блоки первыми, чтобы короткие
+    // находили себя в их хвостах
+    std::vector<const Block*> readOnly;
+    for (const auto& block : blocks) {
+        if (block.bytes % 2 != 0 || block.scope || block.pinned) continue;
+        bool afterData = block.first > 0 && isDataStatement(statements[block.first - 1].get()) &&
+                         !removed[block.first - 1];
+        if (!referenced.count(block.label)) {
+            if (afterData) continue;
+            remove(block);
+            stats.dropped++;
+        } else if (!written.count(block.label) && !block.unique && !block.items.empty()) {
+            readOnly.push_back(&block);
+        }
+    }
+    std::stable_sort(readOnly.begin(), readOnly.end(), [](const Block* a, const Block* b) {
+        return a->items.size() > b->items.size();
+    });
+
+    // Ключ (хеш хвоста, длина) -> (оставленный блок, смещение в байтах)
+    struct Placement {
+        const Block* keeper;
+        size_t offset;
+    };
+    std::unordered_map<uint64_t, std::vector<Placement>> suffixes;
+
+    for (const Block* block : readOnly) {
+        const auto& items = block->items;
+        uint64_t hash = HASH_SEED;
+        for (size_t k = items.size(); k-- > 0;) hash = hashStep(hash, items[k]);
+
+        const Placement* found = nullptr;
+        auto it = suffixes.find(suffixKey(hash, items.size()));
+        if (it != suffixes.end()) {
+            for (const auto& place : it->second) {
+                const auto& tail = place.keeper->items;
+                // Слова блока должны остаться на чётных адресах
+                bool aligned = !block->keepParity || (place.keeper->address + place.offset - block->address) % 2 == 0;
+                if (aligned && tail.size() - place.offset == items.size() &&
+                    std::equal(items.begin(), items.end(), tail.begin() + place.offset)) {
+                    found = &place;
+                    break;
+                }
+            }
+        }
+
+        if (found) {
+            symtab.alias(block->label, found->keeper->label, static_cast<uint16_t>(found->offset));
+            remove(*block);
+            (found->offset ? stats.suffixShared : stats.merged)++;
+            continue;
+        }
+
+        hash = HASH_SEED;
+        for (size_t k = items.size(); k-- > 0;) {
+            hash = hashStep(hash, items[k]);
+            suffixes[suffixKey(hash, items.size() - k)].push_back({block, k});
+        }
+    }
+
+    // Удаление убранных блоков из программы
+    size_t kept = 0;
+    for (size_t i = 0; i < statements.size(); i++) {
+        if (!removed[i]) statements[kept++] = std::move(statements[i]);
+    }
+    statements.resize(kept);
+
+    return stats;
+}
@@ -0,0 +1,65 @@
+#ifndef PDP11_DATAOPT_HPP
+#define PDP11_DATAOPT_HPP
+
+#include "ast.hpp"
+#include "symtab.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+// ========================================================
+// Оптимизация данных: слияние одинаковых блоков и удаление
+// блоков, на которые никто не ссылается
+// ========================================================
+// Блок данных — метка с директивой данных (.WORD, .ASCII...) и следующие за
+// ней директивы данных без меток. Блок только для чтения, если его
+// метка не встречается в приёмнике изменяющей команды (MOV, ADD, CLR...)
+// и в нём нет .BLKB/.BLKW (зарезервированная память — под запись)
+// и .INCBIN (содержимое файла не читается).
+// Адрес метки, попавший в данные (.WORD метка), в смещение метка(Rn) или
+// в @метка, проход не отслеживает: через него блок могут изменить или
+// пройти указателем дальше. Такой блок и данные, идущие за ним вплотную,
+// закреплены — не сливаются и не удаляются.
+// Одинаковые блоки только для чтения сливаются в одну копию, блок,
+// совпадающий с хвостом более длинного, становится этим хвостом.
+// Метки убранных копий становятся псевдонимами в SymbolTable.
+// Блок без ссылок удаляется, только если перед ним нет оставленных данных
+// (иначе до него доходят, читая предыдущие данные подряд).
+// Блоки нечётной длины не трогаются, словные данные не попадают на
+// нечётный адрес.
+// Проход запускается до SymbolTable::build и меняет Program.
+class DataOptimizer {
+public:
+    struct Stats {
+        size_t blocks = 0;       // Помеченных блоков данных
+        size_t merged = 0;       // Слиты с одинаковым блоком
+        size_t suffixShared = 0; // Стали хвостом более длинного блока
+        size_t dropped = 0;      // Удалены: на метку нет ссылок
+        size_t bytesSaved = 0;
+    };
+
+    explicit DataOptimizer(SymbolTable& symtab) : symtab(symtab) {}
+
+    Stats run(Program& program);
+
+private:
+    struct Block {
+        size_t first = 0, last = 0;  // Операторы [first, last) в Program
+        std::string label;
+        uint16_t address = 0;        // Адрес до слияния (важна чётность)
+        std::vector<uint32_t> items; // Содержимое по байтам: значения или ссылки на метки
+        size_t bytes = 0;            // Размер блока в байтах
+        bool keepParity = false;     // Есть .WORD/.FILL/.BLKW или .EVEN/.ODD: чётность адреса важна
+        bool unique = false;         // Не сливается: есть .BLKB/.BLKW/.INCBIN
+        bool scope = false;          // До следующей метки есть n$: без блока их область изменится
+        bool pinned = false;         // Адрес ушёл в данные/индекс или блок вплотную за таким
+    };
+
+    SymbolTable& symtab;
+    std::unordered_map<std::string, uint32_t> labelIds; // Имена меток в items
+
+    void describe(Block& block, const Program& program);
+};
+
+#endif // PDP11_DATAOPT_HPP
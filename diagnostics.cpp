@@ -0,0 +1,25 @@
+#include "diagnostics.hpp"
+
+void DiagnosticEngine::error(const SourceRange& range, std::string message) {
+    items.push_back({Diagnostic::Severity::ERROR, range, std::move(message)});
+    errors++;
+}
+
+void DiagnosticEngine::warning(const SourceRange& range, std::string message) {
+    items.push_back({Diagnostic::Severity::WARNING, range, std::move(message)});
+}
+
+void DiagnosticEngine::clear() {
+    items.clear();
+    errors = 0;
+}
+
+std::string DiagnosticEngine::format(const Diagnostic& diag) {
+    std::string text;
+    if (diag.range.line) {
+        text += std::to_string(diag.range.line) + ":" + std::to_string(diag.range.column) + ": ";
+    }
+    text += diag.severity == Diagnostic::Severity::ERROR ? "error: " : "warning: ";
+    text += diag.message;
+    return text;
+}
@@ -0,0 +1,52 @@
+#ifndef PDP11_DIAGNOSTICS_HPP
+#define PDP11_DIAGNOSTICS_HPP
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstddef>
+
+// Участок исходника, к которому относится сообщение
+struct SourceRange {
+    size_t line = 0;    // 0 — позиция неизвестна
+    size_t column = 0;
+    size_t length = 0;  // Длина в символах (в пределах строки)
+};
+
+struct Diagnostic {
+    enum class Severity { ERROR, WARNING } severity;
+    SourceRange range;
+    std::string message;
+};
+
+// Ошибка раскладки или кодогенерации у конкретного оператора: Assembler
+// переводит её в Diagnostic с этим местом
+class AssemblyError : public std::runtime_error {
+public:
+    AssemblyError(const SourceRange& range, const std::string& message)
+        : std::runtime_error(message), range(range) {}
+
+    SourceRange range;
+};
+
+// Приёмник диагностики: копит все ошибки и предупреждения,
+// исключения для сообщения об ошибке не используются
+class DiagnosticEngine {
+public:
+    void error(const SourceRange& range, std::string message);
+    void warning(const SourceRange& range, std::string message);
+
+    const std::vector<Diagnostic>& diagnostics() const { return items; }
+    size_t errorCount() const { return errors; }
+    bool hasErrors() const { return errors != 0; }
+    void clear();
+
+    // "line:column: error: message"
+    static std::string format(const Diagnostic& diag);
+
+private:
+    std::vector<Diagnostic> items;
+    size_t errors = 0;
+};
+
+#endif // PDP11_DIAGNOSTICS_HPP
@@ -0,0 +1,374 @@
+#include "disasm.hpp"
+#include "isa.hpp"
+
+namespace {
+
+using Format = Disassembler::Format;
+using Type = Instruction::Type;
+
+// Строка таблицы кодов: с base подряд идут коды одного вида
+// (сколько — зависит от формата, см. span). assembler — команда есть
+// в этом ассемблере (её код берётся из isa.hpp)
+struct Row {
+    uint16_t base;
+    Format format;
+    const char* name;
+    bool assembler = false;
+};
+
+constexpr Row ROWS[] = {
+    {isa::baseOpcode(Type::HALT), Format::NONE, "HALT", true},
+    {0000001, Format::NONE, "WAIT"},
+    {0000002, Format::NONE, "RTI"},
+    {0000003, Format::NONE, "BPT"},
+    {0000004, Format::NONE, "IOT"},
+    {0000005, Format::NONE, "RESET"},
+    {0000006, Format::NONE, "RTT"},
+    {isa::baseOpcode(Type::JMP), Format::SINGLE, "JMP", true},
+    {isa::baseOpcode(Type::RTS), Format::REGISTER, "RTS", true},
+    {0000240, Format::NONE, "NOP"},
+    {0000241, Format::NONE, "CLC"},
+    {0000242, Format::NONE, "CLV"},
+    {0000244, Format::NONE, "CLZ"},
+    {0000250, Format::NONE, "CLN"},
+    {0000257, Format::NONE, "CCC"},
+    {0000261, Format::NONE, "SEC"},
+    {0000262, Format::NONE, "SEV"},
+    {0000264, Format::NONE, "SEZ"},
+    {0000270, Format::NONE, "SEN"},
+    {0000277, Format::NONE, "SCC"},
+    {0000300, Format::SINGLE, "SWAB"},
+    {0000400, Format::BRANCH, "BR"},
+    {0001000, Format::BRANCH, "BNE"},
+    {0001400, Format::BRANCH, "BEQ"},
+    {0002000, Format::BRANCH, "BGE"},
+    {0002400, Format::BRANCH, "BLT"},
+    {0003000, Format::BRANCH, "BGT"},
+    {0003400, Format::BRANCH, "BLE"},
+    {isa::baseOpcode(Type::JSR), Format::REG_OPERAND, "JSR", true},
+    {isa::baseOpcode(Type::CLR), Format::SINGLE, "CLR", true},
+    {isa::baseOpcode(Type::COM), Format::SINGLE, "COM", true},
+    {isa::baseOpcode(Type::INC), Format::SINGLE, "INC", true},
+    {isa::baseOpcode(Type::DEC), Format::SINGLE, "DEC", true},
+    {isa::baseOpcode(Type::NEG), Format::SINGLE, "NEG", true},
+    {0005500, Format::SINGLE, "ADC"},
+    {0005600, Format::SINGLE, "SBC"},
+    {0005700, Format::SINGLE, "TST"},
+    {0006000, Format::SINGLE, "ROR"},
+    {0006100, Format::SINGLE, "ROL"},
+    {0006200, Format::SINGLE, "ASR"},
+    {0006300, Format::SINGLE, "ASL"},
+    {0006400, Format::MARK, "MARK"},
+    {0006500, Format::SINGLE, "MFPI"},
+    {0006600, Format::SINGLE, "MTPI"},
+    {0006700, Format::SINGLE, "SXT"},
+    {isa::baseOpcode(Type::MOV), Format::DOUBLE, "MOV", true},
+    {isa::baseOpcode(Type::CMP), Format::DOUBLE, "CMP", true},
+    {0030000, Format::DOUBLE, "BIT"},
+    {0040000, Format::DOUBLE, "BIC"},
+    {0050000, Format::DOUBLE, "BIS"},
+    {isa::baseOpcode(Type::ADD), Format::DOUBLE, "ADD", true},
+    {0070000, Format::OPERAND_REG, "MUL"},
+    {0071000, Format::OPERAND_REG, "DIV"},
+    {0072000, Format::OPERAND_REG, "ASH"},
+    {0073000, Format::OPERAND_REG, "ASHC"},
+    {0074000, Format::REG_OPERAND, "XOR"},
+    {0077000, Format::SOB, "SOB"},
+    {0100000, Format::BRANCH, "BPL"},
+    {0100400, Format::BRANCH, "BMI"},
+    {0101000, Format::BRANCH, "BHI"},
+    {0101400, Format::BRANCH, "BLOS"},
+    {0102000, Format::BRANCH, "BVC"},
+    {0102400, Format::BRANCH, "BVS"},
+    {0103000, Format::BRANCH, "BCC"},
+    {0103400, Format::BRANCH, "BCS"},
+    {0104000, Format::TRAP, "EMT"},
+    {0104400, Format::TRAP, "TRAP"},
+    {0105000, Format::SINGLE, "CLRB"},
+    {0105100, Format::SINGLE, "COMB"},
+    {0105200, Format::SINGLE, "INCB"},
+    {0105300, Format::SINGLE, "DECB"},
+    {0105400, Format::SINGLE, "NEGB"},
+    {0105500, Format::SINGLE, "ADCB"},
+    {0105600, Format::SINGLE, "SBCB"},
+    {0105700, Format::SINGLE, "TSTB"},
+    {0106000, Format::SINGLE, "RORB"},
+    {0106100, Format::SINGLE, "ROLB"},
+    {0106200, Format::SINGLE, "ASRB"},
+    {0106300, Format::SINGLE, "ASLB"},
+    {0106400, Format::SINGLE, "MTPS"},
+    {0106500, Format::SINGLE, "MFPD"},
+    {0106600, Format::SINGLE, "MTPD"},
+    {0106700, Format::SINGLE, "MFPS"},
+    {0110000, Format::DOUBLE, "MOVB"},
+    {0120000, Format::DOUBLE, "CMPB"},
+    {0130000, Format::DOUBLE, "BITB"},
+    {0140000, Format::DOUBLE, "BICB"},
+    {0150000, Format::DOUBLE, "BISB"},
+    {isa::baseOpcode(Type::SUB), Format::DOUBLE, "SUB", true},
+};
+static_assert(sizeof(ROWS) / sizeof(ROWS[0]) < 256, "mnemonic index is 8-bit");
+
+// Сколько кодов занимает строка таблицы
+constexpr uint32_t span(Format format) {
+    switch (format) {
+        case Format::DOUBLE:      return 010000;
+        case Format::REG_OPERAND:
+        case Format::OPERAND_REG:
+        case Format::SOB:         return 01000;
+        case Format::BRANCH:
+        case Format::TRAP:        return 0400;
+        case Format::SINGLE:
+        case Format::MARK:        return 0100;
+        case Format::REGISTER:    return 010;
+        default:                  return 1;
+    }
+}
+
+// Дополнительное слово операнда: #n, @#n (2R, 3R через PC) и режимы 6R, 7R
+constexpr unsigned extension(unsigned field) {
+    unsigned mode = field >> 3;
+    bool pc = (field & 7) == 7;
+    return ((mode == 2 || mode == 3) && pc) || mode == 6 || mode == 7 ? 1 : 0;
+}
+
+// Режим есть в Parser: Rn, (Rn), (Rn)+, -(Rn), X(Rn), #n, @#n, адрес,
+// @адрес. Косвенные 3R, 5R, 7R (кроме @#n и @адрес) и #n в приёмнике
+// (кроме CMP) — нет
+constexpr bool assemblable(unsigned field, bool isSrc) {
+    unsigned mode = field >> 3;
+    bool pc = (field & 7) == 7;
+    switch (mode) {
+        case 2:  return !pc || isSrc;
+        case 3:
+        case 7:  return pc;
+        case 5:  return false;
+        default: return true;
+    }
+}
+
+std::vector<Disassembler::Entry> buildTable() {
+    std::vector<Disassembler::Entry> table(0200000);
+    for (size_t r = 0; r < sizeof(ROWS) / sizeof(ROWS[0]); r++) {
+        const Row& row = ROWS[r];
+        for (uint32_t code = row.base; code < row.base + span(row.format); code++) {
+            unsigned src = (code >> 6) & 077;
+            unsigned dst = code & 077;
+
+            Disassembler::Entry& e = table[code];
+            e.mnemonic = static_cast<uint8_t>(r);
+            e.format = row.format;
+            e.assemblable = row.assembler;
+            switch (row.format) {
+                case Format::DOUBLE:
+                    e.words = static_cast<uint8_t>(1 + extension(src) + extension(dst));
+                    e.assemblable = e.assemblable && assemblable(src, true) &&
+                                    assemblable(dst, row.base == isa::baseOpcode(Type::CMP));
+                    break;
+                case Format::OPERAND_REG:
+                    e.words = static_cast<uint8_t>(1 + extension(dst));
+                    break;
+                case Format::SINGLE:
+                case Format::REG_OPERAND:
+                    e.words = static_cast<uint8_t>(1 + extension(dst));
+                    e.assemblable = e.assemblable && assemblable(dst, false);
+                    // JMP Rn Parser отвергает
+                    if (row.base == isa::baseOpcode(Type::JMP) && (dst >> 3) == 0) e.assemblable = false;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return table;
+}
+
+const std::vector<Disassembler::Entry>& table() {
+    static const std::vector<Disassembler::Entry> entries = buildTable();
+    return entries;
+}
+
+void appendOctal(std::string& out, uint16_t value) {
+    char digits[6];
+    for (int i = 5; i >= 0; i--) {
+        digits[i] = static_cast<char>('0' + (value & 7));
+        value >>= 3;
+    }
+    out.append(digits, 6);
+}
+
+void appendRegister(std::string& out, unsigned reg) {
+    static constexpr const char* NAMES[] = {"R0", "R1", "R2", "R3", "R4", "R5", "SP", "PC"};
+    out += NAMES[reg & 7];
+}
+
+// Операнд по 6-битному полю. ext — его дополнительное слово,
+// next — адрес сразу за этим словом (база относительного режима)
+void appendOperand(std::string& out, unsigned field, uint16_t ext, uint16_t next) {
+    unsigned mode = field >> 3;
+    unsigned reg = field & 7;
+    bool pc = reg == 7;
+    switch (mode) {
+        case 0: appendRegister(out, reg); break;
+        case 1: out += '('; appendRegister(out, reg); out += ')'; break;
+        case 2:
+            if (pc) { out += '#'; appendOctal(out, ext); }
+            else { out += '('; appendRegister(out, reg); out += ")+"; }
+            break;
+        case 3:
+            if (pc) { out += "@#"; appendOctal(out, ext); }
+            else { out += "@("; appendRegister(out, reg); out += ")+"; }
+            break;
+        case 4: out += "-("; appendRegister(out, reg); out += ')'; break;
+        case 5: out += "@-("; appendRegister(out, reg); out += ')'; break;
+        case 6:
+        case 7:
+            if (mode == 7) out += '@';
+            if (pc) { appendOctal(out, static_cast<uint16_t>(next + ext)); }
+            else { appendOctal(out, ext); out += '('; appendRegister(out, reg); out += ')'; }
+            break;
+    }
+}
+
+// Текст команды в out (без перевода строки)
+void appendText(std::string& out, const std::vector<uint16_t>& image, const Disassembler::Decoded& item) {
+    uint16_t word = image[item.offset];
+    if (item.data) {
+        out += ".WORD ";
+        appendOctal(out, word);
+        return;
+    }
+
+    const Disassembler::Entry& e = Disassembler::entry(word);
+    out += Disassembler::mnemonic(e);
+    uint16_t address = static_cast<uint16_t>(2 * item.offset);
+    unsigned src = (word >> 6) & 077;
+    unsigned dst = word & 077;
+    // Дополнительные слова идут по порядку: сначала src, затем dst
+    size_t ext = item.offset + 1;
+    auto operand = [&](unsigned field) {
+        uint16_t value = 0;
+        if (extension(field)) value = image[ext++];
+        appendOperand(out, field, value, static_cast<uint16_t>(2 * ext));
+    };
+
+    switch (e.format) {
+        case Format::DOUBLE:
+            out += ' ';
+            operand(src);
+            out += ',';
+            operand(dst);
+            break;
+        case Format::SINGLE:
+            out += ' ';
+            operand(dst);
+            break;
+        case Format::REG_OPERAND:
+            out += ' ';
+            appendRegister(out, src);
+            out += ',';
+            operand(dst);
+            break;
+        case Format::OPERAND_REG:
+            out += ' ';
+            operand(dst);
+            out += ',';
+            appendRegister(out, src);
+            break;
+        case Format::REGISTER:
+            out += ' ';
+            appendRegister(out, word);
+            break;
+        case Format::BRANCH:
+            out += ' ';
+            appendOctal(out, static_cast<uint16_t>(address + 2 + 2 * static_cast<int8_t>(word & 0377)));
+            break;
+        case Format::SOB:
+            out += ' ';
+            appendRegister(out, src);
+            out += ',';
+            appendOctal(out, static_cast<uint16_t>(address + 2 - 2 * (word & 077)));
+            break;
+        case Format::TRAP:
+            out += ' ';
+            appendOctal(out, word & 0377);
+            break;
+        case Format::MARK:
+            out += ' ';
+            appendOctal(out, word & 077);
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace
+
+const Disassembler::Entry& Disassembler::entry(uint16_t word) {
+    return table()[word];
+}
+
+std::string_view Disassembler::mnemonic(const Entry& entry) {
+    return entry.format == Format::INVALID ? std::string_view(".WORD") : ROWS[entry.mnemonic].name;
+}
+
+void Disassembler::decode(const std::vector<uint16_t>& image, std::vector<Decoded>& out) {
+    const Entry* entries = table().data();
+    const size_t n = image.size();
+    out.clear();
+    out.reserve(n);
+    for (size_t i = 0; i < n;) {
+        uint8_t words = entries[image[i]].words;
+        bool data = entries[image[i]].format == Format::INVALID || i + words > n;
+        if (data) words = 1;
+        out.push_back({static_cast<uint32_t>(i), words, data});
+        i += words;
+    }
+}
+
+std::string Disassembler::text(const std::vector<uint16_t>& image, const Decoded& item) {
+    std::string out;
+    appendText(out, image, item);
+    return out;
+}
+
+std::string Disassembler::listing(const std::vector<uint16_t>& image) {
+    std::vector<Decoded> items;
+    decode(image, items);
+
+    static constexpr size_t COMMENT_COLUMN = 32;
+    std::string out;
+    out.reserve(items.size() * 48);
+    for (const auto& item : items) {
+        size_t start = out.size();
+        out += "    ";
+        bool direct = !item.data && entry(image[item.offset]).assemblable;
+        if (direct) {
+            appendText(out, image, item);
+        } else {
+            // Слова как есть; что это за команда — в комментарии
+            out += ".WORD ";
+            for (size_t k = 0; k < item.words; k++) {
+                if (k) out += ',';
+                appendOctal(out, image[item.offset + k]);
+            }
+        }
+
+        size_t used = out.size() - start;
+        out.append(used < COMMENT_COLUMN ? COMMENT_COLUMN - used : 1, ' ');
+        out += "; ";
+        appendOctal(out, static_cast<uint16_t>(2 * item.offset));
+        if (direct) {
+            for (size_t k = 0; k < item.words; k++) {
+                out += ' ';
+                appendOctal(out, image[item.offset + k]);
+            }
+        } else if (!item.data) {
+            out += ' ';
+            appendText(out, image, item);
+        }
+        out += '\n';
+    }
+    out += "    .END\n";
+    return out;
+}
@@ -0,0 +1,61 @@
+#ifndef PDP11_DISASM_HPP
+#define PDP11_DISASM_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// ========================================================
+// Дизассемблер PDP-11 по таблице на все 64K слов
+// ========================================================
+// Таблица строится один раз: для каждого слова — мнемоника, формат,
+// длина команды в словах и можно ли её собрать этим ассемблером.
+// Разбор образа — один поиск в таблице на команду, без ветвлений по
+// кодам операций. Образ считается загруженным с адреса 0.
+class Disassembler {
+public:
+    enum class Format : uint8_t {
+        INVALID,      // Не команда: .WORD
+        NONE,         // HALT, NOP, RTI...
+        DOUBLE,       // MOV src,dst
+        SINGLE,       // CLR dst
+        REG_OPERAND,  // JSR R,dst; XOR R,dst
+        OPERAND_REG,  // MUL src,R
+        REGISTER,     // RTS R
+        BRANCH,       // BR адрес (8-битное смещение)
+        SOB,          // SOB R,адрес
+        TRAP,         // EMT n, TRAP n (8 бит)
+        MARK,         // MARK n (6 бит)
+    };
+
+    struct Entry {
+        uint8_t mnemonic = 0;         // Номер строки таблицы кодов
+        Format format = Format::INVALID;
+        uint8_t words = 1;            // Вместе с дополнительными словами
+        bool assemblable = false;     // Текст команды собирается в те же биты
+    };
+
+    // Команда или слово данных в образе
+    struct Decoded {
+        uint32_t offset;  // Индекс первого слова (адрес / 2)
+        uint8_t words;
+        bool data;        // Не команда или образ кончился раньше команды
+    };
+
+    static const Entry& entry(uint16_t word);
+    static std::string_view mnemonic(const Entry& entry);
+
+    // Разбор всего образа подряд (буфер out переиспользуется)
+    static void decode(const std::vector<uint16_t>& image, std::vector<Decoded>& out);
+
+    // Текст команды: "MOV R1,-(SP)"; для данных — ".WORD 012345"
+    static std::string text(const std::vector<uint16_t>& image, const Decoded& item);
+
+    // Исходный текст образа: этот ассемблер соберёт его в тот же образ
+    // бит в бит. Команды, которые он не поддерживает, выводятся через
+    // .WORD с мнемоникой в комментарии; адрес и слова — в комментарии
+    static std::string listing(const std::vector<uint16_t>& image);
+};
+
+#endif // PDP11_DISASM_HPP
@@ -0,0 +1,1052 @@
+#include "emulator.hpp"
+#include <array>
+#include <cstring>
+
+// Computed goto есть в GCC и Clang; иначе — обычный switch
+#if defined(__GNUC__) && !defined(PDP11_NO_COMPUTED_GOTO)
+#define PDP11_COMPUTED_GOTO 1
+#endif
+
+// Биты условий PSW
+static constexpr uint16_t CC_N = 010;
+static constexpr uint16_t CC_Z = 004;
+static constexpr uint16_t CC_V = 002;
+static constexpr uint16_t CC_C = 001;
+
+// ========================================================
+// 1. Таблица обработчиков: каждое из 65536 слов заранее
+//    сопоставлено своему обработчику. У частых команд режимы
+//    операндов тоже разобраны заранее: _RR — регистр-регистр,
+//    _IR — #n в регистр, _PR/_RP — относительный адрес (67) и регистр,
+//    _R — однооперандная над регистром
+// ========================================================
+#define PDP11_OPS(X) \
+    X(ILLEGAL) X(HALT) X(WAIT) X(RTI) X(BPT) X(IOT) X(RESET) X(RTT) \
+    X(JMP) X(RTS) X(CCC) X(SWAB) X(JSR) X(SXT) \
+    X(BR) X(BNE) X(BEQ) X(BGE) X(BLT) X(BGT) X(BLE) \
+    X(BPL) X(BMI) X(BHI) X(BLOS) X(BVC) X(BVS) X(BCC) X(BCS) \
+    X(CLR) X(COM) X(INC) X(DEC) X(NEG) X(ADC) X(SBC) X(TST) \
+    X(ROR) X(ROL) X(ASR) X(ASL) \
+    X(CLRB) X(COMB) X(INCB) X(DECB) X(NEGB) X(ADCB) X(SBCB) X(TSTB) \
+    X(RORB) X(ROLB) X(ASRB) X(ASLB) \
+    X(MOV) X(CMP) X(BIT) X(BIC) X(BIS) X(ADD) X(SUB) \
+    X(MOVB) X(CMPB) X(BITB) X(BICB) X(BISB) \
+    X(MUL) X(DIV) X(ASH) X(ASHC) X(XOR) X(SOB) X(EMT) X(TRAP) \
+    X(MOV_RR) X(MOV_IR) X(MOV_PR) X(MOV_RP) \
+    X(CMP_RR) X(CMP_IR) X(CMP_PR) X(CMP_RP) \
+    X(ADD_RR) X(ADD_IR) X(ADD_PR) X(ADD_RP) \
+    X(SUB_RR) X(SUB_IR) X(SUB_PR) X(SUB_RP) \
+    X(CLR_R) X(INC_R) X(DEC_R) X(TST_R)
+
+enum class Op : uint8_t {
+#define PDP11_OP_ENUM(name) name,
+    PDP11_OPS(PDP11_OP_ENUM)
+#undef PDP11_OP_ENUM
+};
+
+static Op classify(uint16_t w) {
+    switch (w) {
+        case 0: return Op::HALT;
+        case 1: return Op::WAIT;
+        case 2: return Op::RTI;
+        case 3: return Op::BPT;
+        case 4: return Op::IOT;
+        case 5: return Op::RESET;
+        case 6: return Op::RTT;
+        default: break;
+    }
+    if ((w & 0177700) == 0000100) return Op::JMP;
+    if ((w & 0177770) == 0000200) return Op::RTS;
+    if (w >= 0000240 && w <= 0000277) return Op::CCC;
+    if ((w & 0177700) == 0000300) return Op::SWAB;
+
+    static const Op branches[16] = {
+        Op::ILLEGAL, Op::BR, Op::BNE, Op::BEQ, Op::BGE, Op::BLT, Op::BGT, Op::BLE,
+        Op::BPL, Op::BMI, Op::BHI, Op::BLOS, Op::BVC, Op::BVS, Op::BCC, Op::BCS
+    };
+    if ((w & 0074000) == 0 && (w & 0003400) != 0) {
+        // 000400-003777 и 100000-103777: биты 15 и 10-8 выбирают ветвление
+        return branches[((w >> 12) & 010) | ((w >> 8) & 7)];
+    }
+    if ((w & 0177000) == 0004000) return Op::JSR;
+
+    static const Op single[12] = {
+        Op::CLR, Op::COM, Op::INC, Op::DEC, Op::NEG, Op::ADC, Op::SBC, Op::TST,
+        Op::ROR, Op::ROL, Op::ASR, Op::ASL
+    };
+    static const Op singleByte[12] = {
+        Op::CLRB, Op::COMB, Op::INCB, Op::DECB, Op::NEGB, Op::ADCB, Op::SBCB, Op::TSTB,
+        Op::RORB, Op::ROLB, Op::ASRB, Op::ASLB
+    };
+    if (w >= 0005000 && w <= 0006377) return single[(w - 0005000) >> 6];
+    if (w >= 0105000 && w <= 0106377) return singleByte[(w - 0105000) >> 6];
+    if ((w & 0177700) == 0006700) return Op::SXT;
+
+    switch (w & 0177000) {
+        case 0070000: return Op::MUL;
+        case 0071000: return Op::DIV;
+        case 0072000: return Op::ASH;
+        case 0073000: return Op::ASHC;
+        case 0074000: return Op::XOR;
+        case 0077000: return Op::SOB;
+        default: break;
+    }
+    if ((w & 0177400) == 0104000) return Op::EMT;
+    if ((w & 0177400) == 0104400) return Op::TRAP;
+
+    switch (w & 0170000) {
+        case 0010000: return Op::MOV;
+        case 0020000: return Op::CMP;
+        case 0030000: return Op::BIT;
+        case 0040000: return Op::BIC;
+        case 0050000: return Op::BIS;
+        case 0060000: return Op::ADD;
+        case 0110000: return Op::MOVB;
+        case 0120000: return Op::CMPB;
+        case 0130000: return Op::BITB;
+        case 0140000: return Op::BICB;
+        case 0150000: return Op::BISB;
+        case 0160000: return Op::SUB;
+        default: break;
+    }
+    return Op::ILLEGAL;
+}
+
+// Обработчик с заранее разобранными режимами, если он есть
+static Op specialize(Op op, uint16_t w) {
+    unsigned src = (w >> 6) & 077;
+    unsigned dst = w & 077;
+    bool dstReg = (dst & 070) == 0;
+
+    static const Op twoOperand[4][4] = {
+        {Op::MOV_RR, Op::MOV_IR, Op::MOV_PR, Op::MOV_RP},
+        {Op::CMP_RR, Op::CMP_IR, Op::CMP_PR, Op::CMP_RP},
+        {Op::ADD_RR, Op::ADD_IR, Op::ADD_PR, Op::ADD_RP},
+        {Op::SUB_RR, Op::SUB_IR, Op::SUB_PR, Op::SUB_RP},
+    };
+    int row;
+    switch (op) {
+        case Op::MOV: row = 0; break;
+        case Op::CMP: row = 1; break;
+        case Op::ADD: row = 2; break;
+        case Op::SUB: row = 3; break;
+        case Op::CLR: return dstReg ? Op::CLR_R : op;
+        case Op::INC: return dstReg ? Op::INC_R : op;
+        case Op::DEC: return dstReg ? Op::DEC_R : op;
+        case Op::TST: return dstReg ? Op::TST_R : op;
+        default: return op;
+    }
+    if ((src & 070) == 0 && dstReg) return twoOperand[row][0];
+    if (src == 027 && dstReg) return twoOperand[row][1];
+    if (src == 067 && dstReg) return twoOperand[row][2];
+    if ((src & 070) == 0 && dst == 067) return twoOperand[row][3];
+    return op;
+}
+
+static const std::array<Op, 65536>& decodeTable() {
+    static const std::array<Op, 65536> table = [] {
+        std::array<Op, 65536> t{};
+        for (uint32_t w = 0; w < 65536; w++) {
+            t[w] = specialize(classify(static_cast<uint16_t>(w)), static_cast<uint16_t>(w));
+        }
+        return t;
+    }();
+    return table;
+}
+
+// ========================================================
+// 2. Память и устройства
+// ========================================================
+Emulator::Emulator() {
+    decodeTable(); // Таблица строится при первом создании эмулятора
+}
+
+void Emulator::load(const std::vector<uint16_t>& image, uint16_t address) {
+    uint32_t addr = address & ~1u;
+    for (auto word : image) {
+        if (addr + 1 >= IO_PAGE) break;
+        memory[addr] = static_cast<uint8_t>(word & 0xFF);
+        memory[addr + 1] = static_cast<uint8_t>(word >> 8);
+        addr += 2;
+    }
+    reset(address);
+}
+
+void Emulator::reset(uint16_t pc, uint16_t sp) {
+    for (auto& reg : r) reg = 0;
+    r[6] = sp;
+    r[7] = pc;
+    psw = 0;
+    executed = 0;
+    faulted = false;
+    console.clear();
+}
+
+void Emulator::setConsoleInput(const std::string& text) {
+    consoleInput = text;
+    inputPos = 0;
+}
+
+void Emulator::fail(Stop reason, uint16_t addr) {
+    if (faulted) return;
+    faulted = true;
+    faultReason = reason;
+    faultAddress = addr;
+    budget = 0; // Цикл выполнения остановится перед следующей командой
+}
+
+inline uint16_t Emulator::read16(uint16_t addr) {
+    if (addr & 1) {
+        fail(Stop::ODD_ADDRESS, addr);
+        return 0;
+    }
+    if (addr >= IO_PAGE) return ioRead(addr);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint16_t value;
+    std::memcpy(&value, &memory[addr], 2);
+    return value;
+#else
+    return static_cast<uint16_t>(memory[addr] | (memory[addr + 1] << 8));
+#endif
+}
+
+inline uint8_t Emulator::read8(uint16_t addr) {
+    if (addr >= IO_PAGE) {
+        uint16_t word = ioRead(addr & ~1);
+        return static_cast<uint8_t>((addr & 1) ? word >> 8 : word);
+    }
+    return memory[addr];
+}
+
+inline void Emulator::write16(uint16_t addr, uint16_t value) {
+    if (addr & 1) {
+        fail(Stop::ODD_ADDRESS, addr);
+        return;
+    }
+    if (addr >= IO_PAGE) {
+        ioWrite(addr, value);
+        return;
+    }
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::memcpy(&memory[addr], &value, 2);
+#else
+    memory[addr] = static_cast<uint8_t>(value);
+    memory[addr + 1] = static_cast<uint8_t>(value >> 8);
+#endif
+}
+
+inline void Emulator::write8(uint16_t addr, uint8_t value) {
+    if (addr >= IO_PAGE) {
+        // Старшие байты регистров устройств не используются
+        if (!(addr & 1)) ioWrite(addr, value);
+        return;
+    }
+    memory[addr] = value;
+}
+
+uint16_t Emulator::ioRead(uint16_t addr) {
+    switch (addr) {
+        case CONSOLE_RCSR:
+            return inputPos < consoleInput.size() ? 0200 : 0;
+        case CONSOLE_RBUF:
+            if (inputPos < consoleInput.size()) {
+                return static_cast<uint8_t>(consoleInput[inputPos++]);
+            }
+            return 0;
+        case CONSOLE_XCSR:
+            return 0200; // Передатчик всегда готов
+        case CONSOLE_XBUF:
+            return 0;
+        case PSW_ADDRESS:
+            return psw;
+        default:
+            fail(Stop::BUS_ERROR, addr);
+            return 0;
+    }
+}
+
+void Emulator::ioWrite(uint16_t addr, uint16_t value) {
+    switch (addr) {
+        case CONSOLE_XBUF:
+            console.push_back(static_cast<char>(value & 0xFF));
+            break;
+        case CONSOLE_RCSR:
+        case CONSOLE_RBUF:
+        case CONSOLE_XCSR:
+            break; // Прерывания консоли не поддерживаются
+        case PSW_ADDRESS:
+            psw = value & 0377;
+            break;
+        default:
+            fail(Stop::BUS_ERROR, addr);
+            break;
+    }
+}
+
+// ========================================================
+// 3. Адресация
+// ========================================================
+inline uint16_t Emulator::fetch() {
+    uint16_t pc = r[7];
+    r[7] += 2;
+    return read16(pc);
+}
+
+// Исполнительный адрес для режимов 1-7 (size — 1 или 2 байта).
+// SP и PC всегда изменяются на 2.
+inline uint16_t Emulator::address(unsigned spec, unsigned size) {
+    unsigned reg = spec & 7;
+    unsigned step = reg >= 6 ? 2 : size;
+    switch (spec >> 3) {
+        case 1:
+            return r[reg];
+        case 2: {
+            uint16_t addr = r[reg];
+            r[reg] += step;
+            return addr;
+        }
+        case 3: {
+            uint16_t ptr = r[reg];
+            r[reg] += 2;
+            return read16(ptr);
+        }
+        case 4:
+            r[reg] -= step;
+            return r[reg];
+        case 5:
+            r[reg] -= 2;
+            return read16(r[reg]);
+        case 6: {
+            uint16_t index = fetch();
+            return static_cast<uint16_t>(r[reg] + index);
+        }
+        default: {
+            uint16_t index = fetch();
+            return read16(static_cast<uint16_t>(r[reg] + index));
+        }
+    }
+}
+
+inline void Emulator::push(uint16_t value) {
+    r[6] -= 2;
+    write16(r[6], value);
+}
+
+inline uint16_t Emulator::pop() {
+    uint16_t value = read16(r[6]);
+    r[6] += 2;
+    return value;
+}
+
+void Emulator::trap(uint16_t vector) {
+    uint16_t oldPsw = psw;
+    uint16_t oldPc = r[7];
+    push(oldPsw);
+    push(oldPc);
+    r[7] = read16(vector);
+    psw = read16(vector + 2);
+}
+
+const char* Emulator::stopName(Stop stop) {
+    switch (stop) {
+        case Stop::HALT: return "HALT";
+        case Stop::WAIT: return "WAIT";
+        case Stop::LIMIT: return "instruction limit";
+        case Stop::ODD_ADDRESS: return "odd address";
+        case Stop::BUS_ERROR: return "bus error";
+        case Stop::ILLEGAL_INSTRUCTION: return "illegal instruction";
+    }
+    return "?";
+}
+
+// ========================================================
+// 4. Цикл выполнения
+// ========================================================
+static inline uint16_t nz16(uint16_t v) {
+    return (v & 0100000 ? CC_N : 0) | (v == 0 ? CC_Z : 0);
+}
+
+static inline uint16_t nz8(uint8_t v) {
+    return (v & 0200 ? CC_N : 0) | (v == 0 ? CC_Z : 0);
+}
+
+// Флаги сложения, вычитания (dst - src) и сравнения (src - dst)
+static inline uint16_t addFlags(uint16_t src, uint16_t dst, uint16_t res) {
+    return nz16(res) | ((~(src ^ dst) & (src ^ res) & 0100000) ? CC_V : 0) | (res < src ? CC_C : 0);
+}
+
+static inline uint16_t subFlags(uint16_t src, uint16_t dst, uint16_t res) {
+    return nz16(res) | (((src ^ dst) & (dst ^ res) & 0100000) ? CC_V : 0) | (dst < src ? CC_C : 0);
+}
+
+// V = N xor C для сдвигов
+static inline uint16_t shiftFlags(uint16_t nz, bool carry) {
+    uint16_t f = nz | (carry ? CC_C : 0);
+    if (((f & CC_N) != 0) != carry) f |= CC_V;
+    return f;
+}
+
+#define SET_CC(flags) (psw = static_cast<uint16_t>((psw & ~017) | (flags)))
+#define MOV_CC(value) (psw = static_cast<uint16_t>((psw & ~(CC_N | CC_Z | CC_V)) | nz16(value)))
+
+// Операнды: режим 0 обслуживается без вычисления адреса
+#define SRC_W(spec) (((spec) & 070) ? read16(address((spec), 2)) : r[(spec) & 7])
+#define SRC_B(spec) (((spec) & 070) ? read8(address((spec), 1)) : static_cast<uint8_t>(r[(spec) & 7]))
+
+#define DST_W(spec) \
+    uint16_t dstAddr = 0; \
+    uint16_t dst = ((spec) & 070) ? read16(dstAddr = address((spec), 2)) : r[(spec) & 7]
+#define DST_B(spec) \
+    uint16_t dstAddr = 0; \
+    uint8_t dst = ((spec) & 070) ? read8(dstAddr = address((spec), 1)) : static_cast<uint8_t>(r[(spec) & 7])
+
+#define STORE_W(spec, value) \
+    do { \
+        if ((spec) & 070) write16(dstAddr, (value)); \
+        else r[(spec) & 7] = (value); \
+    } while (0)
+#define STORE_B(spec, value) \
+    do { \
+        if ((spec) & 070) write8(dstAddr, (value)); \
+        else r[(spec) & 7] = static_cast<uint16_t>((r[(spec) & 7] & 0177400) | static_cast<uint8_t>(value)); \
+    } while (0)
+
+// Относительный адрес (режим 67): смещение и PC после его выборки
+#define PC_RELATIVE(addr) \
+    uint16_t addr = fetch(); \
+    addr = static_cast<uint16_t>(addr + r[7])
+
+#define BRANCH_IF(cond) \
+    do { \
+        if (cond) r[7] = static_cast<uint16_t>(r[7] + 2 * static_cast<int8_t>(ir & 0377)); \
+    } while (0)
+
+#ifdef PDP11_COMPUTED_GOTO
+#define OP(name) op_##name:
+#define NEXT goto next
+#else
+#define OP(name) case Op::name:
+#define NEXT break
+#endif
+
+Emulator::Stop Emulator::run(uint64_t maxInstructions) {
+    const Op* table = decodeTable().data();
+    uint64_t count = 0;
+    uint16_t ir = 0;
+    Stop stop = Stop::LIMIT;
+    budget = maxInstructions;
+
+#ifdef PDP11_COMPUTED_GOTO
+    static void* const dispatch[] = {
+#define PDP11_OP_LABEL(name) &&op_##name,
+        PDP11_OPS(PDP11_OP_LABEL)
+#undef PDP11_OP_LABEL
+    };
+
+next:
+    if (count >= budget) goto done;
+    ir = fetch();
+    count++;
+    goto *dispatch[static_cast<uint8_t>(table[ir])];
+#else
+    for (;;) {
+        if (count >= budget) goto done;
+        ir = fetch();
+        count++;
+        switch (table[ir]) {
+#endif
+
+    // ---------- Без операндов ----------
+    OP(HALT) { stop = Stop::HALT; goto done; }
+    OP(WAIT) { stop = Stop::WAIT; goto done; }
+    OP(RESET) { NEXT; }
+    OP(RTI)
+    OP(RTT) {
+        r[7] = pop();
+        psw = pop();
+        NEXT;
+    }
+    OP(BPT) { trap(014); NEXT; }
+    OP(IOT) { trap(020); NEXT; }
+    OP(EMT) { trap(030); NEXT; }
+    OP(TRAP) { trap(034); NEXT; }
+    OP(CCC) {
+        if (ir & 020) psw |= ir & 017;
+        else psw &= ~(ir & 017);
+        NEXT;
+    }
+    OP(ILLEGAL) {
+        fail(Stop::ILLEGAL_INSTRUCTION, static_cast<uint16_t>(r[7] - 2));
+        NEXT;
+    }
+
+    // ---------- Переходы ----------
+    OP(JMP) {
+        if ((ir & 070) == 0) {
+            fail(Stop::ILLEGAL_INSTRUCTION, static_cast<uint16_t>(r[7] - 2));
+            NEXT;
+        }
+        r[7] = address(ir & 077, 2);
+        NEXT;
+    }
+    OP(JSR) {
+        if ((ir & 070) == 0) {
+            fail(Stop::ILLEGAL_INSTRUCTION, static_cast<uint16_t>(r[7] - 2));
+            NEXT;
+        }
+        unsigned reg = (ir >> 6) & 7;
+        uint16_t target = address(ir & 077, 2);
+        push(r[reg]);
+        r[reg] = r[7];
+        r[7] = target;
+        NEXT;
+    }
+    OP(RTS) {
+        unsigned reg = ir & 7;
+        r[7] = r[reg];
+        r[reg] = pop();
+        NEXT;
+    }
+    OP(SOB) {
+        unsigned reg = (ir >> 6) & 7;
+        if (--r[reg]) r[7] = static_cast<uint16_t>(r[7] - 2 * (ir & 077));
+        NEXT;
+    }
+    OP(BR)   { BRANCH_IF(true); NEXT; }
+    OP(BNE)  { BRANCH_IF(!(psw & CC_Z)); NEXT; }
+    OP(BEQ)  { BRANCH_IF(psw & CC_Z); NEXT; }
+    OP(BGE)  { BRANCH_IF(!(psw & CC_N) == !(psw & CC_V)); NEXT; }
+    OP(BLT)  { BRANCH_IF(!(psw & CC_N) != !(psw & CC_V)); NEXT; }
+    OP(BGT)  { BRANCH_IF(!(psw & CC_Z) && !(psw & CC_N) == !(psw & CC_V)); NEXT; }
+    OP(BLE)  { BRANCH_IF((psw & CC_Z) || !(psw & CC_N) != !(psw & CC_V)); NEXT; }
+    OP(BPL)  { BRANCH_IF(!(psw & CC_N)); NEXT; }
+    OP(BMI)  { BRANCH_IF(psw & CC_N); NEXT; }
+    OP(BHI)  { BRANCH_IF(!(psw & (CC_C | CC_Z))); NEXT; }
+    OP(BLOS) { BRANCH_IF(psw & (CC_C | CC_Z)); NEXT; }
+    OP(BVC)  { BRANCH_IF(!(psw & CC_V)); NEXT; }
+    OP(BVS)  { BRANCH_IF(psw & CC_V); NEXT; }
+    OP(BCC)  { BRANCH_IF(!(psw & CC_C)); NEXT; }
+    OP(BCS)  { BRANCH_IF(psw & CC_C); NEXT; }
+
+    // ---------- Двухоперандные (слово) ----------
+    OP(MOV) {
+        uint16_t src = SRC_W((ir >> 6) & 077);
+        if (ir & 070) write16(address(ir & 077, 2), src);
+        else r[ir & 7] = src;
+        MOV_CC(src);
+        NEXT;
+    }
+    OP(CMP) {
+        uint16_t src = SRC_W((ir >> 6) & 077);
+        uint16_t dst = SRC_W(ir & 077);
+        SET_CC(subFlags(dst, src, static_cast<uint16_t>(src - dst)));
+        NEXT;
+    }
+    OP(BIT) {
+        uint16_t src = SRC_W((ir >> 6) & 077);
+        uint16_t dst = SRC_W(ir & 077);
+        SET_CC(nz16(src & dst) | (psw & CC_C));
+        NEXT;
+    }
+    OP(BIC) {
+        uint16_t src = SRC_W((ir >> 6) & 077);
+        DST_W(ir & 077);
+        uint16_t res = dst & ~src;
+        STORE_W(ir & 077, res);
+        SET_CC(nz16(res) | (psw & CC_C));
+        NEXT;
+    }
+    OP(BIS) {
+        uint16_t src = SRC_W((ir >> 6) & 077);
+        DST_W(ir & 077);
+        uint16_t res = dst | src;
+        STORE_W(ir & 077, res);
+        SET_CC(nz16(res) | (psw & CC_C));
+        NEXT;
+    }
+    OP(ADD) {
+        uint16_t src = SRC_W((ir >> 6) & 077);
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>(src + dst);
+        STORE_W(ir & 077, res);
+        SET_CC(addFlags(src, dst, res));
+        NEXT;
+    }
+    OP(SUB) {
+        uint16_t src = SRC_W((ir >> 6) & 077);
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>(dst - src);
+        STORE_W(ir & 077, res);
+        SET_CC(subFlags(src, dst, res));
+        NEXT;
+    }
+    OP(XOR) {
+        uint16_t src = r[(ir >> 6) & 7];
+        DST_W(ir & 077);
+        uint16_t res = dst ^ src;
+        STORE_W(ir & 077, res);
+        SET_CC(nz16(res) | (psw & CC_C));
+        NEXT;
+    }
+
+    // ---------- Заранее разобранные режимы ----------
+    // Порядок выборки тот же, что в обобщённых обработчиках:
+    // сначала источник, затем слово смещения приёмника
+    OP(MOV_RR) {
+        uint16_t src = r[(ir >> 6) & 7];
+        r[ir & 7] = src;
+        MOV_CC(src);
+        NEXT;
+    }
+    OP(MOV_IR) {
+        uint16_t src = fetch();
+        r[ir & 7] = src;
+        MOV_CC(src);
+        NEXT;
+    }
+    OP(MOV_PR) {
+        PC_RELATIVE(addr);
+        uint16_t src = read16(addr);
+        r[ir & 7] = src;
+        MOV_CC(src);
+        NEXT;
+    }
+    OP(MOV_RP) {
+        uint16_t src = r[(ir >> 6) & 7];
+        PC_RELATIVE(addr);
+        write16(addr, src);
+        MOV_CC(src);
+        NEXT;
+    }
+    OP(CMP_RR) {
+        uint16_t src = r[(ir >> 6) & 7];
+        uint16_t dst = r[ir & 7];
+        SET_CC(subFlags(dst, src, static_cast<uint16_t>(src - dst)));
+        NEXT;
+    }
+    OP(CMP_IR) {
+        uint16_t src = fetch();
+        uint16_t dst = r[ir & 7];
+        SET_CC(subFlags(dst, src, static_cast<uint16_t>(src - dst)));
+        NEXT;
+    }
+    OP(CMP_PR) {
+        PC_RELATIVE(addr);
+        uint16_t src = read16(addr);
+        uint16_t dst = r[ir & 7];
+        SET_CC(subFlags(dst, src, static_cast<uint16_t>(src - dst)));
+        NEXT;
+    }
+    OP(CMP_RP) {
+        uint16_t src = r[(ir >> 6) & 7];
+        PC_RELATIVE(addr);
+        uint16_t dst = read16(addr);
+        SET_CC(subFlags(dst, src, static_cast<uint16_t>(src - dst)));
+        NEXT;
+    }
+    OP(ADD_RR) {
+        uint16_t src = r[(ir >> 6) & 7];
+        uint16_t dst = r[ir & 7];
+        uint16_t res = static_cast<uint16_t>(src + dst);
+        r[ir & 7] = res;
+        SET_CC(addFlags(src, dst, res));
+        NEXT;
+    }
+    OP(ADD_IR) {
+        uint16_t src = fetch();
+        uint16_t dst = r[ir & 7];
+        uint16_t res = static_cast<uint16_t>(src + dst);
+        r[ir & 7] = res;
+        SET_CC(addFlags(src, dst, res));
+        NEXT;
+    }
+    OP(ADD_PR) {
+        PC_RELATIVE(addr);
+        uint16_t src = read16(addr);
+        uint16_t dst = r[ir & 7];
+        uint16_t res = static_cast<uint16_t>(src + dst);
+        r[ir & 7] = res;
+        SET_CC(addFlags(src, dst, res));
+        NEXT;
+    }
+    OP(ADD_RP) {
+        uint16_t src = r[(ir >> 6) & 7];
+        PC_RELATIVE(addr);
+        uint16_t dst = read16(addr);
+        uint16_t res = static_cast<uint16_t>(src + dst);
+        write16(addr, res);
+        SET_CC(addFlags(src, dst, res));
+        NEXT;
+    }
+    OP(SUB_RR) {
+        uint16_t src = r[(ir >> 6) & 7];
+        uint16_t dst = r[ir & 7];
+        uint16_t res = static_cast<uint16_t>(dst - src);
+        r[ir & 7] = res;
+        SET_CC(subFlags(src, dst, res));
+        NEXT;
+    }
+    OP(SUB_IR) {
+        uint16_t src = fetch();
+        uint16_t dst = r[ir & 7];
+        uint16_t res = static_cast<uint16_t>(dst - src);
+        r[ir & 7] = res;
+        SET_CC(subFlags(src, dst, res));
+        NEXT;
+    }
+    OP(SUB_PR) {
+        PC_RELATIVE(addr);
+        uint16_t src = read16(addr);
+        uint16_t dst = r[ir & 7];
+        uint16_t res = static_cast<uint16_t>(dst - src);
+        r[ir & 7] = res;
+        SET_CC(subFlags(src, dst, res));
+        NEXT;
+    }
+    OP(SUB_RP) {
+        uint16_t src = r[(ir >> 6) & 7];
+        PC_RELATIVE(addr);
+        uint16_t dst = read16(addr);
+        uint16_t res = static_cast<uint16_t>(dst - src);
+        write16(addr, res);
+        SET_CC(subFlags(src, dst, res));
+        NEXT;
+    }
+    OP(CLR_R) {
+        r[ir & 7] = 0;
+        SET_CC(CC_Z);
+        NEXT;
+    }
+    OP(INC_R) {
+        uint16_t dst = r[ir & 7];
+        uint16_t res = static_cast<uint16_t>(dst + 1);
+        r[ir & 7] = res;
+        SET_CC(nz16(res) | (dst == 0077777 ? CC_V : 0) | (psw & CC_C));
+        NEXT;
+    }
+    OP(DEC_R) {
+        uint16_t dst = r[ir & 7];
+        uint16_t res = static_cast<uint16_t>(dst - 1);
+        r[ir & 7] = res;
+        SET_CC(nz16(res) | (dst == 0100000 ? CC_V : 0) | (psw & CC_C));
+        NEXT;
+    }
+    OP(TST_R) {
+        SET_CC(nz16(r[ir & 7]));
+        NEXT;
+    }
+
+    // ---------- Двухоперандные (байт) ----------
+    OP(MOVB) {
+        uint8_t src = SRC_B((ir >> 6) & 077);
+        // В регистр MOVB пишет байт со знаковым расширением
+        if (ir & 070) write8(address(ir & 077, 1), src);
+        else r[ir & 7] = static_cast<uint16_t>(static_cast<int16_t>(static_cast<int8_t>(src)));
+        psw = static_cast<uint16_t>((psw & ~(CC_N | CC_Z | CC_V)) | nz8(src));
+        NEXT;
+    }
+    OP(CMPB) {
+        uint8_t src = SRC_B((ir >> 6) & 077);
+        uint8_t dst = SRC_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>(src - dst);
+        SET_CC(nz8(res) | (((src ^ dst) & (src ^ res) & 0200) ? CC_V : 0) | (src < dst ? CC_C : 0));
+        NEXT;
+    }
+    OP(BITB) {
+        uint8_t src = SRC_B((ir >> 6) & 077);
+        uint8_t dst = SRC_B(ir & 077);
+        SET_CC(nz8(src & dst) | (psw & CC_C));
+        NEXT;
+    }
+    OP(BICB) {
+        uint8_t src = SRC_B((ir >> 6) & 077);
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>(dst & ~src);
+        STORE_B(ir & 077, res);
+        SET_CC(nz8(res) | (psw & CC_C));
+        NEXT;
+    }
+    OP(BISB) {
+        uint8_t src = SRC_B((ir >> 6) & 077);
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>(dst | src);
+        STORE_B(ir & 077, res);
+        SET_CC(nz8(res) | (psw & CC_C));
+        NEXT;
+    }
+
+    // ---------- Однооперандные (слово) ----------
+    OP(CLR) {
+        DST_W(ir & 077);
+        (void)dst;
+        STORE_W(ir & 077, 0);
+        SET_CC(CC_Z);
+        NEXT;
+    }
+    OP(COM) {
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>(~dst);
+        STORE_W(ir & 077, res);
+        SET_CC(nz16(res) | CC_C);
+        NEXT;
+    }
+    OP(INC) {
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>(dst + 1);
+        STORE_W(ir & 077, res);
+        SET_CC(nz16(res) | (dst == 0077777 ? CC_V : 0) | (psw & CC_C));
+        NEXT;
+    }
+    OP(DEC) {
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>(dst - 1);
+        STORE_W(ir & 077, res);
+        SET_CC(nz16(res) | (dst == 0100000 ? CC_V : 0) | (psw & CC_C));
+        NEXT;
+    }
+    OP(NEG) {
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>(-dst);
+        STORE_W(ir & 077, res);
+        SET_CC(nz16(res) | (res == 0100000 ? CC_V : 0) | (res ? CC_C : 0));
+        NEXT;
+    }
+    OP(ADC) {
+        DST_W(ir & 077);
+        bool carry = psw & CC_C;
+        uint16_t res = static_cast<uint16_t>(dst + carry);
+        STORE_W(ir & 077, res);
+        SET_CC(nz16(res) | (carry && dst == 0077777 ? CC_V : 0) | (carry && dst == 0177777 ? CC_C : 0));
+        NEXT;
+    }
+    OP(SBC) {
+        DST_W(ir & 077);
+        bool carry = psw & CC_C;
+        uint16_t res = static_cast<uint16_t>(dst - carry);
+        STORE_W(ir & 077, res);
+        SET_CC(nz16(res) | (carry && dst == 0100000 ? CC_V : 0) | (carry && dst == 0 ? CC_C : 0));
+        NEXT;
+    }
+    OP(TST) {
+        uint16_t dst = SRC_W(ir & 077);
+        SET_CC(nz16(dst));
+        NEXT;
+    }
+    OP(ROR) {
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>((dst >> 1) | ((psw & CC_C) ? 0100000 : 0));
+        STORE_W(ir & 077, res);
+        SET_CC(shiftFlags(nz16(res), dst & 1));
+        NEXT;
+    }
+    OP(ROL) {
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>((dst << 1) | ((psw & CC_C) ? 1 : 0));
+        STORE_W(ir & 077, res);
+        SET_CC(shiftFlags(nz16(res), dst & 0100000));
+        NEXT;
+    }
+    OP(ASR) {
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>((dst >> 1) | (dst & 0100000));
+        STORE_W(ir & 077, res);
+        SET_CC(shiftFlags(nz16(res), dst & 1));
+        NEXT;
+    }
+    OP(ASL) {
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>(dst << 1);
+        STORE_W(ir & 077, res);
+        SET_CC(shiftFlags(nz16(res), dst & 0100000));
+        NEXT;
+    }
+    OP(SWAB) {
+        DST_W(ir & 077);
+        uint16_t res = static_cast<uint16_t>((dst << 8) | (dst >> 8));
+        STORE_W(ir & 077, res);
+        SET_CC(nz8(static_cast<uint8_t>(res)));
+        NEXT;
+    }
+    OP(SXT) {
+        DST_W(ir & 077);
+        (void)dst;
+        uint16_t res = (psw & CC_N) ? 0177777 : 0;
+        STORE_W(ir & 077, res);
+        psw = static_cast<uint16_t>((psw & ~(CC_Z | CC_V)) | (res ? 0 : CC_Z));
+        NEXT;
+    }
+
+    // ---------- Однооперандные (байт) ----------
+    OP(CLRB) {
+        DST_B(ir & 077);
+        (void)dst;
+        STORE_B(ir & 077, 0);
+        SET_CC(CC_Z);
+        NEXT;
+    }
+    OP(COMB) {
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>(~dst);
+        STORE_B(ir & 077, res);
+        SET_CC(nz8(res) | CC_C);
+        NEXT;
+    }
+    OP(INCB) {
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>(dst + 1);
+        STORE_B(ir & 077, res);
+        SET_CC(nz8(res) | (dst == 0177 ? CC_V : 0) | (psw & CC_C));
+        NEXT;
+    }
+    OP(DECB) {
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>(dst - 1);
+        STORE_B(ir & 077, res);
+        SET_CC(nz8(res) | (dst == 0200 ? CC_V : 0) | (psw & CC_C));
+        NEXT;
+    }
+    OP(NEGB) {
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>(-dst);
+        STORE_B(ir & 077, res);
+        SET_CC(nz8(res) | (res == 0200 ? CC_V : 0) | (res ? CC_C : 0));
+        NEXT;
+    }
+    OP(ADCB) {
+        DST_B(ir & 077);
+        bool carry = psw & CC_C;
+        uint8_t res = static_cast<uint8_t>(dst + carry);
+        STORE_B(ir & 077, res);
+        SET_CC(nz8(res) | (carry && dst == 0177 ? CC_V : 0) | (carry && dst == 0377 ? CC_C : 0));
+        NEXT;
+    }
+    OP(SBCB) {
+        DST_B(ir & 077);
+        bool carry = psw & CC_C;
+        uint8_t res = static_cast<uint8_t>(dst - carry);
+        STORE_B(ir & 077, res);
+        SET_CC(nz8(res) | (carry && dst == 0200 ? CC_V : 0) | (carry && dst == 0 ? CC_C : 0));
+        NEXT;
+    }
+    OP(TSTB) {
+        uint8_t dst = SRC_B(ir & 077);
+        SET_CC(nz8(dst));
+        NEXT;
+    }
+    OP(RORB) {
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>((dst >> 1) | ((psw & CC_C) ? 0200 : 0));
+        STORE_B(ir & 077, res);
+        SET_CC(shiftFlags(nz8(res), dst & 1));
+        NEXT;
+    }
+    OP(ROLB) {
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>((dst << 1) | ((psw & CC_C) ? 1 : 0));
+        STORE_B(ir & 077, res);
+        SET_CC(shiftFlags(nz8(res), dst & 0200));
+        NEXT;
+    }
+    OP(ASRB) {
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>((dst >> 1) | (dst & 0200));
+        STORE_B(ir & 077, res);
+        SET_CC(shiftFlags(nz8(res), dst & 1));
+        NEXT;
+    }
+    OP(ASLB) {
+        DST_B(ir & 077);
+        uint8_t res = static_cast<uint8_t>(dst << 1);
+        STORE_B(ir & 077, res);
+        SET_CC(shiftFlags(nz8(res), dst & 0200));
+        NEXT;
+    }
+
+    // ---------- EIS ----------
+    OP(MUL) {
+        unsigned reg = (ir >> 6) & 7;
+        int32_t product = static_cast<int16_t>(r[reg]) * static_cast<int16_t>(SRC_W(ir & 077));
+        if (reg & 1) {
+            r[reg] = static_cast<uint16_t>(product);
+        } else {
+            r[reg] = static_cast<uint16_t>(static_cast<uint32_t>(product) >> 16);
+            r[reg | 1] = static_cast<uint16_t>(product);
+        }
+        SET_CC((product < 0 ? CC_N : 0) | (product == 0 ? CC_Z : 0) |
+               (product < -32768 || product > 32767 ? CC_C : 0));
+        NEXT;
+    }
+    OP(DIV) {
+        unsigned reg = (ir >> 6) & 7;
+        int16_t divisor = static_cast<int16_t>(SRC_W(ir & 077));
+        int64_t dividend = static_cast<int32_t>((static_cast<uint32_t>(r[reg]) << 16) | r[reg | 1]);
+        if (divisor == 0) {
+            SET_CC(CC_V | CC_C);
+            NEXT;
+        }
+        int64_t quotient = dividend / divisor;
+        int64_t remainder = dividend % divisor;
+        if (quotient < -32768 || quotient > 32767) {
+            SET_CC(CC_V);
+            NEXT;
+        }
+        r[reg] = static_cast<uint16_t>(quotient);
+        r[reg | 1] = static_cast<uint16_t>(remainder);
+        SET_CC((quotient < 0 ? CC_N : 0) | (quotient == 0 ? CC_Z : 0));
+        NEXT;
+    }
+    OP(ASH) {
+        unsigned reg = (ir >> 6) & 7;
+        int shift = SRC_W(ir & 077) & 077;
+        if (shift & 040) shift -= 64;
+        int16_t value = static_cast<int16_t>(r[reg]);
+        int16_t res = value;
+        bool carry = false;
+        if (shift > 0) {
+            carry = shift <= 16 && ((static_cast<uint16_t>(value) >> (16 - shift)) & 1);
+            res = shift < 16 ? static_cast<int16_t>(static_cast<uint16_t>(value) << shift) : 0;
+        } else if (shift < 0) {
+            int count = -shift;
+            carry = count <= 16 ? (value >> (count - 1)) & 1 : value < 0;
+            res = static_cast<int16_t>(value >> (count < 15 ? count : 15));
+        }
+        r[reg] = static_cast<uint16_t>(res);
+        SET_CC(nz16(static_cast<uint16_t>(res)) | (((value ^ res) & 0100000) ? CC_V : 0) | (carry ? CC_C : 0));
+        NEXT;
+    }
+    OP(ASHC) {
+        unsigned reg = (ir >> 6) & 7;
+        int shift = SRC_W(ir & 077) & 077;
+        if (shift & 040) shift -= 64;
+        int32_t value = static_cast<int32_t>((static_cast<uint32_t>(r[reg]) << 16) | r[reg | 1]);
+        int32_t res = value;
+        bool carry = false;
+        if (shift > 0) {
+            carry = (static_cast<uint32_t>(value) >> (32 - shift)) & 1;
+            res = static_cast<int32_t>(static_cast<uint64_t>(static_cast<uint32_t>(value)) << shift);
+        } else if (shift < 0) {
+            int count = -shift;
+            carry = (static_cast<int64_t>(value) >> (count - 1)) & 1;
+            res = static_cast<int32_t>(static_cast<int64_t>(value) >> count);
+        }
+        r[reg] = static_cast<uint16_t>(static_cast<uint32_t>(res) >> 16);
+        r[reg | 1] = static_cast<uint16_t>(res);
+        SET_CC((res < 0 ? CC_N : 0) | (res == 0 ? CC_Z : 0) |
+               (((value ^ res) & 0x80000000) ? CC_V : 0) | (carry ? CC_C : 0));
+        NEXT;
+    }
+
+#ifndef PDP11_COMPUTED_GOTO
+        }
+    }
+#endif
+
+done:
+    executed += count;
+    lastInstruction = ir;
+    if (faulted) {
+        faulted = false;
+        return faultReason;
+    }
+    return stop;
+}
@@ -0,0 +1,89 @@
+#ifndef PDP11_EMULATOR_HPP
+#define PDP11_EMULATOR_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// ========================================================
+// Эмулятор процессора PDP-11 (базовый набор команд 11/40 + EIS)
+// ========================================================
+// Память 64 КБ: 0-157777 — ОЗУ, 160000-177777 — страница ввода-вывода.
+// Устройства: консоль (177560-177566) и регистр PSW (177776).
+// Команды заранее раскладываются по таблице обработчиков на 64K слов,
+// выборка идёт через computed goto (GCC/Clang) или switch. У MOV, CMP,
+// ADD, SUB, CLR, INC, DEC, TST в таблице разобраны и частые режимы
+// (регистр, #n, относительный адрес), без общего декодера адреса.
+//
+// Отличие от 11/40, намеренное: нечётный адрес, несуществующий адрес
+// и недопустимая команда не прерывают программу через векторы 4 и 10,
+// а останавливают run() с причиной ODD_ADDRESS, BUS_ERROR или
+// ILLEGAL_INSTRUCTION и адресом в faultAddress. Эмулятор проверяет
+// собранные образы, и ошибка в них должна быть видна сразу, а не
+// уходить в обработчик, которого в образе обычно нет.
+class Emulator {
+public:
+    // Причина остановки
+    enum class Stop {
+        HALT,                // Выполнена HALT
+        WAIT,                // WAIT без источников прерываний
+        LIMIT,               // Исчерпан лимит команд
+        ODD_ADDRESS,         // Обращение к слову по нечётному адресу
+        BUS_ERROR,           // Несуществующий адрес в странице ввода-вывода
+        ILLEGAL_INSTRUCTION  // Резервная или недопустимая команда
+    };
+
+    static constexpr uint16_t IO_PAGE = 0160000;
+    static constexpr uint16_t CONSOLE_RCSR = 0177560;
+    static constexpr uint16_t CONSOLE_RBUF = 0177562;
+    static constexpr uint16_t CONSOLE_XCSR = 0177564;
+    static constexpr uint16_t CONSOLE_XBUF = 0177566;
+    static constexpr uint16_t PSW_ADDRESS = 0177776;
+
+    Emulator();
+
+    // Загрузка образа (слова little-endian) и сброс процессора
+    void load(const std::vector<uint16_t>& image, uint16_t address = 0);
+    void reset(uint16_t pc, uint16_t sp = IO_PAGE);
+
+    // Выполнение до остановки, но не более maxInstructions команд
+    Stop run(uint64_t maxInstructions);
+
+    // Байты, которые будет читать программа из консоли
+    void setConsoleInput(const std::string& text);
+
+    static const char* stopName(Stop stop);
+
+    uint16_t r[8] = {};          // R0-R5, SP (R6), PC (R7)
+    uint16_t psw = 0;            // Биты N=010, Z=04, V=02, C=01
+    uint64_t executed = 0;       // Всего выполнено команд
+    uint16_t faultAddress = 0;   // Адрес для ODD_ADDRESS/BUS_ERROR
+    uint16_t lastInstruction = 0;
+    std::string console;         // Вывод программы в консоль
+
+private:
+    uint16_t read16(uint16_t addr);
+    uint8_t read8(uint16_t addr);
+    void write16(uint16_t addr, uint16_t value);
+    void write8(uint16_t addr, uint8_t value);
+    uint16_t ioRead(uint16_t addr);
+    void ioWrite(uint16_t addr, uint16_t value);
+
+    uint16_t fetch();
+    uint16_t address(unsigned spec, unsigned size);
+    void push(uint16_t value);
+    uint16_t pop();
+    void trap(uint16_t vector);
+
+    void fail(Stop reason, uint16_t addr);
+
+    std::string consoleInput;
+    size_t inputPos = 0;
+    bool faulted = false;
+    Stop faultReason = Stop::HALT;
+    uint64_t budget = 0;         // Лимит текущего run(); при сбое обнуляется
+
+    uint8_t memory[65536] = {};
+};
+
+#endif // PDP11_EMULATOR_HPP
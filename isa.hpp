@@ -0,0 +1,118 @@
+#ifndef PDP11_ISA_HPP
+#define PDP11_ISA_HPP
+
+#include "ast.hpp"
+#include <cstdint>
+#include <string_view>
+
+// ========================================================
+// Правила кодирования PDP-11, общие для CodeGenerator,
+// SymbolTable и compile-time ассемблера (constexpr_asm.hpp)
+// ========================================================
+namespace isa {
+
+// Адресное пространство: 64K байт (0–0177777)
+constexpr uint32_t ADDRESS_SPACE = 0200000;
+
+// Код операции без полей операндов
+constexpr uint16_t baseOpcode(Instruction::Type type) {
+    switch (type) {
+        case Instruction::Type::MOV:  return 0010000; // MOV src,dst
+        case Instruction::Type::CMP:  return 0020000; // CMP src,dst
+        case Instruction::Type::ADD:  return 0060000; // ADD src,dst
+        case Instruction::Type::SUB:  return 0160000; // SUB src,dst
+        case Instruction::Type::JSR:  return 0004000; // JSR R,dst
+        case Instruction::Type::RTS:  return 0000200; // RTS R
+        case Instruction::Type::HALT: return 0000000; // HALT
+        case Instruction::Type::CLR:  return 0005000; // CLR dst
+        case Instruction::Type::COM:  return 0005100; // COM dst
+        case Instruction::Type::INC:  return 0005200; // INC dst
+        case Instruction::Type::DEC:  return 0005300; // DEC dst
+        case Instruction::Type::NEG:  return 0005400; // NEG dst
+        case Instruction::Type::JMP:  return 0000100; // JMP dst
+    }
+    return 0;
+}
+
+// Номер регистра (R0-R7, SP, PC) или -1
+constexpr int registerNumber(std::string_view name) {
+    if (name == "PC") return 7;
+    if (name == "SP") return 6;
+    if (name.size() == 2 && name[0] == 'R' && name[1] >= '0' && name[1] <= '7') {
+        return name[1] - '0';
+    }
+    return -1;
+}
+
+// 6-битное поле операнда: режим << 3 | регистр.
+// Режимы через PC (27, 37, 67, 77) регистр не используют.
+constexpr uint16_t operandField(AddrMode mode, int reg) {
+    switch (mode) {
+        case AddrMode::REGISTER:  return static_cast<uint16_t>(reg);
+        case AddrMode::IMMEDIATE: return 027; // #n
+        case AddrMode::ABSOLUTE:  return 037; // @#address
+        case AddrMode::RELATIVE:  return 067; // address
+        case AddrMode::RELATIVE_DEF: return 077; // @address
+        case AddrMode::REG_DEF:   return static_cast<uint16_t>(010 | reg);
+        case AddrMode::AUTOINC:   return static_cast<uint16_t>(020 | reg);
+        case AddrMode::AUTODEC:   return static_cast<uint16_t>(040 | reg);
+        case AddrMode::INDEXED:   return static_cast<uint16_t>(060 | reg);
+    }
+    return 0;
+}
+
+// Режим операнда-метки: label — относительный (67), @label — косвенный
+// относительный (77). Общий для Parser и constexpr_asm.hpp
+constexpr AddrMode labelMode(bool deferred) {
+    return deferred ? AddrMode::RELATIVE_DEF : AddrMode::RELATIVE;
+}
+
+// Слово команды из кода операции и полей: src — поле источника или
+// регистр связи JSR, dst — поле приёмника или регистр RTS
+constexpr uint16_t instructionWord(Instruction::Type type, uint16_t src, uint16_t dst) {
+    return static_cast<uint16_t>(baseOpcode(type) | (src << 6) | dst);
+}
+
+// Приёмник только читается: #n в нём допустим (CMP R0,#100)
+constexpr bool readOnlyDestination(Instruction::Type type) {
+    return type == Instruction::Type::CMP;
+}
+
+// Недопустимый приёмник команды: текст ошибки или nullptr
+constexpr const char* destinationError(Instruction::Type type, AddrMode mode) {
+    if (mode == AddrMode::IMMEDIATE && !readOnlyDestination(type)) {
+        return "Immediate mode not allowed for destination";
+    }
+    if (type == Instruction::Type::JMP && mode == AddrMode::REGISTER) return "JMP to a register is illegal";
+    return nullptr;
+}
+
+// Число дополнительных слов операнда
+constexpr unsigned extensionWords(AddrMode mode) {
+    switch (mode) {
+        case AddrMode::IMMEDIATE:
+        case AddrMode::ABSOLUTE:
+        case AddrMode::RELATIVE:
+        case AddrMode::RELATIVE_DEF:
+        case AddrMode::INDEXED:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Значение дополнительного слова: value — число или адрес метки, next —
+// адрес сразу за этим словом. Режимы через PC (67, 77) хранят смещение
+constexpr uint16_t extensionWord(AddrMode mode, uint16_t value, uint16_t next) {
+    switch (mode) {
+        case AddrMode::RELATIVE:
+        case AddrMode::RELATIVE_DEF:
+            return static_cast<uint16_t>(value - next);
+        default:
+            return value;
+    }
+}
+
+} // namespace isa
+
+#endif // PDP11_ISA_HPP
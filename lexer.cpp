@@ -1,15 +1,82 @@
 #include "lexer.hpp"
+#include "literal.hpp"
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <stdexcept>
 
-Lexer::Lexer(const std::string &source) : source(source) {}
+Lexer::Lexer(std::string_view source, size_t firstLine) : source(source), firstLine(firstLine) {}
+
+// ========================================================
+// Индекс начал строк
+// ========================================================
+void LineIndex::build(std::string_view text, size_t first) {
+    firstLine = first;
+    starts.assign(1, 0);
+    const char* data = text.data();
+    size_t size = text.size();
+    for (size_t from = 0; from < size;) {
+        const void* eol = std::memchr(data + from, '\n', size - from);
+        if (!eol) break;
+        from = static_cast<size_t>(static_cast<const char*>(eol) - data) + 1;
+        starts.push_back(static_cast<uint32_t>(from));
+    }
+}
+
+size_t LineIndex::index(uint32_t offset) const {
+    return static_cast<size_t>(std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin()) - 1;
+}
+
+size_t LineIndex::line(uint32_t offset) const {
+    return firstLine + index(offset);
+}
+
+size_t LineIndex::line(uint32_t offset, size_t& hint) const {
+    if (hint >= starts.size() || starts[hint] > offset) return firstLine + (hint = index(offset));
+    while (hint + 1 < starts.size() && starts[hint + 1] <= offset) hint++;
+    return firstLine + hint;
+}
+
+size_t LineIndex::column(uint32_t offset) const {
+    return offset - starts[index(offset)] + 1;
+}
 
 std::vector<Token> Lexer::tokenize() {
     std::vector<Token> tokens;
+    tokenize(tokens);
+    return tokens;
+}
+
+void Lexer::tokenize(std::vector<Token> &tokens) {
+    tokens.clear();
+    position = 0;
+    newLine = true;
+    lineIndex.build(source, firstLine);
+    currentRadix = initialRadix;
+    conditions = initialConditions;
+    if (!conditions.active()) skipInactive();
 
     while (position < source.size()) {
         char current = peek();
 
+        if (current == '.') {
+            size_t length;
+            Conditional kind = conditionalAt(length);
+            if (kind != Conditional::NONE) {
+                if (!statementStart(tokens)) {
+                    // То же правило, что при пропуске неактивного текста
+                    std::string word(source.substr(position, length));
+                    tokens.push_back({TokenType::ERROR, word + " must start a statement",
+                                      static_cast<uint32_t>(position), static_cast<uint32_t>(length), true});
+                    while (position < source.size() && peek() != '\n') advance();
+                    continue;
+                }
+                parseConditional(kind, length, tokens);
+                if (!conditions.active() && !skipInactive()) break;
+                continue;
+            }
+        }
+
         if (isspace(current)) {
             skipWhitespace();
             continue;
@@ -24,70 +91,105 @@ std::vector<Token> Lexer::tokenize() {
         }
 
         if (isDigit(current)) {
-            tokens.push_back(parseNumber());
+            // Локальная метка n$: цифры и '$'
+            size_t digits = 1;
+            while (position + digits < source.size() && isDigit(source[position + digits])) digits++;
+            if (position + digits < source.size() && source[position + digits] == '$') {
+                tokens.push_back(parseLocalLabel(digits));
+                continue;
+            }
+
+            // Аргумент .RADIX всегда десятичный
+            bool radixArgument = !tokens.empty() && tokens.back().type == TokenType::DIRECTIVE_RADIX &&
+                                 !newLine;
+            tokens.push_back(parseNumber(radixArgument));
+            // .EQU NAME, число — значение нужно условиям ниже по тексту
+            size_t n = tokens.size();
+            if (n >= 4 && tokens[n - 1].type == TokenType::NUMBER && tokens[n - 4].type == TokenType::DIRECTIVE_EQU &&
+                tokens[n - 3].type == TokenType::LABEL && tokens[n - 2].type == TokenType::COMMA &&
+                !tokens[n - 3].lineStart && !tokens[n - 2].lineStart && !tokens[n - 1].lineStart) {
+                conditions.constants[tokens[n - 3].value] = static_cast<int32_t>(tokens[n - 1].number);
+            }
             continue;
         }
 
         if (isAlpha(current) || current == '.') {
             tokens.push_back(parseIdentifierOrKeyword());
+            // .RADIX без аргумента возвращает восьмеричную систему
+            if (tokens.back().type == TokenType::DIRECTIVE_RADIX) currentRadix = 8;
+            continue;
+        }
+
+        if (current == '"') {
+            tokens.push_back(parseString());
             continue;
         }
 
         if (current == ':') {
-            tokens.push_back({TokenType::COLON, ":", line, column});
+            if (!tokens.empty() && tokens.back().type == TokenType::LABEL && !newLine &&
+                !isDigit(tokens.back().value[0])) {
+                conditions.labels.insert(tokens.back().value);
+            }
+            tokens.push_back(makeToken(TokenType::COLON, ":", position));
             advance();
             continue;
         }
 
         if (current == ',') {
-            tokens.push_back({TokenType::COMMA, ",", line, column});
+            tokens.push_back(makeToken(TokenType::COMMA, ",", position));
             advance();
             continue;
         }
 
         if (current == '(') {
-            tokens.push_back({TokenType::LPAREN, "(", line, column});
+            tokens.push_back(makeToken(TokenType::LPAREN, "(", position));
             advance();
             continue;
         }
 
         if (current == ')') {
-            tokens.push_back({TokenType::RPAREN, ")", line, column});
+            tokens.push_back(makeToken(TokenType::RPAREN, ")", position));
             advance();
             continue;
         }
 
         if (current == '#') {
-            tokens.push_back({TokenType::HASH, "#", line, column});
+            tokens.push_back(makeToken(TokenType::HASH, "#", position));
             advance();
             continue;
         }
 
         if (current == '@') {
-            tokens.push_back({TokenType::AT, "@", line, column});
+            tokens.push_back(makeToken(TokenType::AT, "@", position));
             advance();
             continue;
         }
 
         if (current == '+') {
-            tokens.push_back({TokenType::PLUS, "+", line, column});
+            tokens.push_back(makeToken(TokenType::PLUS, "+", position));
             advance();
             continue;
         }
 
         if (current == '-') {
-            tokens.push_back({TokenType::MINUS, "-", line, column});
+            tokens.push_back(makeToken(TokenType::MINUS, "-", position));
             advance();
             continue;
         }
 
         // Неизвестный символ
-        tokens.push_back({TokenType::UNKNOWN, std::string(1, current), line, column});
+        tokens.push_back(makeToken(TokenType::UNKNOWN, std::string(1, current), position));
         advance();
     }
 
-    tokens.push_back({TokenType::END_OF_FILE, "", line, column});
-    return tokens;
+    if (!partial) {
+        // Ошибка в конце текста: строка .IF — в сообщении
+        for (const auto& block : conditions.blocks) {
+            tokens.push_back({TokenType::ERROR, "Missing .ENDC for .IF at line " + std::to_string(block.line),
+                              static_cast<uint32_t>(source.size()), 0, true});
+        }
+    }
+    tokens.push_back(makeToken(TokenType::END_OF_FILE, "", source.size()));
 }
 
 char Lexer::peek() const {
@@ -96,20 +198,19 @@ char Lexer::peek() const {
 
 char Lexer::advance() {
     if (position >= source.size()) return '\0';
+    return source[position++];
+}
 
-    char current = source[position++];
-    if (current == '\n') {
-        line++;
-        column = 1;
-    } else {
-        column++;
-    }
-    return current;
+// Позиция токена — смещение; строку и столбец даст LineIndex
+Token Lexer::makeToken(TokenType type, std::string value, size_t start, uint32_t number) {
+    Token token{type, std::move(value), static_cast<uint32_t>(start), number, newLine};
+    newLine = false;
+    return token;
 }
 
 void Lexer::skipWhitespace() {
     while (isspace(peek())) {
-        advance();
+        if (advance() == '\n') newLine = true;
     }
 }
 
@@ -125,63 +226,291 @@ bool Lexer::isAlphaNumeric(char c) const {
     return isAlpha(c) || isDigit(c);
 }
 
-Token Lexer::parseNumber() {
+Token Lexer::parseNumber(bool radixArgument) {
     size_t start = position;
-    size_t startLine = line;
-    size_t startColumn = column;
 
-    // Обработка шестнадцатеричных (0x...), восьмеричных (0o...) и десятичных чисел
-    if (peek() == '0') {
-        advance();
-        if (peek() == 'x' || peek() == 'X') {
-            advance(); // Пропускаем 'x' или 'X'
-            while (isxdigit(peek())) advance();
-        } else if (peek() == 'o' || peek() == 'O') {
-            advance(); // Пропускаем 'o' или 'O'
-            while (peek() >= '0' && peek() <= '7') advance();
-        } else {
-            while (isDigit(peek())) advance();
-        }
-    } else {
-        while (isDigit(peek())) advance();
+    auto literal = literal::parse(source.substr(position), radixArgument ? 10 : currentRadix);
+    std::string text(source.substr(position, literal.length));
+    position += literal.length;
+
+    // Неверная цифра или переполнение: парсер сообщит "Invalid number"
+    if (literal.status != literal::Status::OK) {
+        return makeToken(TokenType::UNKNOWN, text, start);
+    }
+    if (radixArgument && literal::validRadix(literal.value)) {
+        currentRadix = literal.value;
     }
+    return makeToken(TokenType::NUMBER, text, start, literal.value);
+}
 
-    std::string value = source.substr(start, position - start);
-    return {TokenType::NUMBER, value, startLine, startColumn};
+// n$: LABEL, n (десятичное) — в number; 0, если n вне 1-65535
+// (парсер сообщит об ошибке)
+Token Lexer::parseLocalLabel(size_t digits) {
+    size_t start = position;
+    std::string text(source.substr(position, digits + 1));
+    position += digits + 1;
+
+    auto literal = literal::parse(std::string_view(text).substr(0, digits), 10);
+    uint32_t number = literal.status == literal::Status::OK && literal.value <= 0xFFFF ? literal.value : 0;
+    return makeToken(TokenType::LABEL, text, start, number);
 }
 
 Token Lexer::parseIdentifierOrKeyword() {
     size_t start = position;
-    size_t startLine = line;
-    size_t startColumn = column;
 
     while (isAlphaNumeric(peek()) || peek() == '.') {
         advance();
     }
 
-    std::string value = source.substr(start, position - start);
+    std::string value(source.substr(start, position - start));
 
     // Проверяем, является ли ключевым словом (командой)
     if (keywords.find(value) != keywords.end()) {
-        return {keywords.at(value), value, startLine, startColumn};
+        return makeToken(keywords.at(value), value, start);
     }
 
     // Проверяем, является ли директивой
     if (directives.find(value) != directives.end()) {
-        return {directives.at(value), value, startLine, startColumn};
+        return makeToken(directives.at(value), value, start);
     }
 
     // Проверяем, является ли регистром (R0-R7, SP, PC)
     if ((value.size() == 2 || value.size() == 3) && (value[0] == 'R' || value == "SP" || value == "PC")) {
         if (value[0] == 'R') {
             if (value.size() == 2 && value[1] >= '0' && value[1] <= '7') {
-                return {TokenType::REGISTER, value, startLine, startColumn};
+                return makeToken(TokenType::REGISTER, value, start);
             }
         } else if (value == "SP" || value == "PC") {
-            return {TokenType::REGISTER, value, startLine, startColumn};
+            return makeToken(TokenType::REGISTER, value, start);
         }
     }
 
     // В противном случае — это метка или неизвестный идентификатор
-    return {TokenType::LABEL, value, startLine, startColumn};
+    return makeToken(TokenType::LABEL, value, start);
+}
+
+Token Lexer::parseString() {
+    size_t quote = position;
+    advance(); // Пропускаем открывающую кавычку
+
+    size_t start = position;
+    while (position < source.size() && peek() != '"' && peek() != '\n') {
+        advance();
+    }
+    std::string value(source.substr(start, position - start));
+
+    // Незакрытая строка: отдаём парсеру как неизвестный токен
+    if (peek() != '"') {
+        return makeToken(TokenType::UNKNOWN, "\"" + value, quote);
+    }
+    advance(); // Пропускаем закрывающую кавычку
+    return makeToken(TokenType::STRING, value, quote);
+}
+
+// ========================================================
+// Условное ассемблирование
+// ========================================================
+
+// Условие — отдельный оператор: первое в строке, перед ним только
+// метки "X:" и "n$:". Это же правило у skipInactive
+bool Lexer::statementStart(const std::vector<Token>& tokens) const {
+    if (newLine) return true;
+    size_t n = tokens.size();
+    while (n >= 2 && tokens[n - 1].type == TokenType::COLON && tokens[n - 2].type == TokenType::LABEL) {
+        if (tokens[n - 2].lineStart) return true;
+        n -= 2;
+    }
+    return false;
+}
+
+// Директива условия в позиции position ('.'); length — длина имени
+Lexer::Conditional Lexer::conditionalAt(size_t& length) const {
+    size_t end = position + 1;
+    while (end < source.size() && isAlpha(source[end])) end++;
+    length = end - position;
+    if (end < source.size() && (isDigit(source[end]) || source[end] == '.')) return Conditional::NONE;
+
+    std::string_view word = source.substr(position, length);
+    if (word == ".ENDC") return Conditional::ENDC;
+    if (word == ".IFF") return Conditional::IFF;
+    if (word == ".IFT") return Conditional::IFT;
+    if (word == ".IFTF") return Conditional::IFTF;
+    // .IF cond, arg и краткие .IFDF arg, .IFEQ arg...
+    if (word.substr(0, 3) == ".IF") return Conditional::IF;
+    return Conditional::NONE;
+}
+
+void Lexer::parseConditional(Conditional kind, size_t length, std::vector<Token>& tokens) {
+    size_t start = position;
+    std::string word(source.substr(position, length));
+    position += length;
+
+    std::string error;
+    using Part = ConditionState::Block::Part;
+    switch (kind) {
+        case Conditional::IF: {
+            if (!conditions.active()) {
+                // Вложенный блок в неактивном тексте не вычисляется
+                conditions.blocks.push_back({false, false, Part::IFT, lineIndex.line(start)});
+                while (position < source.size() && peek() != '\n') advance();
+                return;
+            }
+            std::string_view condition = std::string_view(word).substr(3);
+            if (condition.empty()) {
+                skipSpaces();
+                condition = readWord();
+                skipSpaces();
+                if (peek() == ',') advance();
+            }
+            bool value = evaluateCondition(condition, error);
+            conditions.blocks.push_back({value, true, Part::IFT, lineIndex.line(start)});
+            break;
+        }
+        case Conditional::IFF:
+        case Conditional::IFT:
+        case Conditional::IFTF:
+            if (conditions.blocks.empty()) {
+                error = word + " outside of a conditional block";
+                break;
+            }
+            conditions.blocks.back().part = kind == Conditional::IFF ? Part::IFF
+                                          : kind == Conditional::IFT ? Part::IFT : Part::IFTF;
+            break;
+        case Conditional::ENDC:
+            if (conditions.blocks.empty()) error = "Unmatched .ENDC";
+            else conditions.blocks.pop_back();
+            break;
+        case Conditional::NONE:
+            break;
+    }
+
+    // После условия — только комментарий
+    skipSpaces();
+    if (error.empty() && position < source.size() && peek() != '\n' && peek() != ';') {
+        error = "Unexpected text after " + word;
+    }
+    while (position < source.size() && peek() != '\n') advance();
+    if (!error.empty()) {
+        tokens.push_back({TokenType::ERROR, error, static_cast<uint32_t>(start), static_cast<uint32_t>(length), true});
+    }
+}
+
+// Аргумент — число (можно с минусом) или символ; сравнение как у
+// MACRO-11, со знаковым 16-битным значением
+bool Lexer::evaluateCondition(std::string_view condition, std::string& error) {
+    static constexpr std::string_view KNOWN[] = {"EQ", "Z", "NE", "NZ", "GT", "G", "LT", "L",
+                                                 "GE", "LE", "DF", "NDF"};
+    if (std::find(std::begin(KNOWN), std::end(KNOWN), condition) == std::end(KNOWN)) {
+        error = "Unknown condition: " + std::string(condition);
+        return false;
+    }
+    skipSpaces();
+    bool negative = peek() == '-';
+    if (negative) {
+        advance();
+        skipSpaces();
+    }
+
+    uint32_t raw = 0;
+    std::string_view name;
+    if (isDigit(peek())) {
+        auto literal = literal::parse(source.substr(position), currentRadix);
+        position += literal.length;
+        if (literal.status != literal::Status::OK) {
+            error = "Invalid number in condition";
+            return false;
+        }
+        raw = literal.value;
+    } else if (isAlpha(peek())) {
+        name = readWord();
+    } else {
+        error = "Expected argument for .IF";
+        return false;
+    }
+
+    if (condition == "DF" || condition == "NDF") {
+        if (name.empty() || negative) {
+            error = "Expected symbol for .IF " + std::string(condition);
+            return false;
+        }
+        std::string symbol(name);
+        conditions.consulted.insert(symbol);
+        bool defined = conditions.constants.count(symbol) || conditions.labels.count(symbol);
+        return condition == "DF" ? defined : !defined;
+    }
+
+    if (!name.empty()) {
+        std::string symbol(name);
+        conditions.consulted.insert(symbol);
+        auto it = conditions.constants.find(symbol);
+        if (it == conditions.constants.end()) {
+            error = (conditions.labels.count(symbol) ? "Label is not a constant in .IF: "
+                                                     : "Undefined symbol in .IF: ") + symbol;
+            return false;
+        }
+        raw = static_cast<uint32_t>(it->second);
+    }
+    int32_t value = static_cast<int16_t>(raw);
+    if (negative) value = static_cast<int16_t>(-value);
+
+    if (condition == "EQ" || condition == "Z") return value == 0;
+    if (condition == "NE" || condition == "NZ") return value != 0;
+    if (condition == "GT" || condition == "G") return value > 0;
+    if (condition == "LT" || condition == "L") return value < 0;
+    if (condition == "GE") return value >= 0;
+    return value <= 0;
+}
+
+// Неактивный текст: просмотр по строкам (memchr до '\n') в поисках
+// строки, которая начинается с .IF*/.ENDC (возможно, после меток, как
+// в statementStart). Возвращает false в конце текста
+bool Lexer::skipInactive() {
+    const char* data = source.data();
+    size_t size = source.size();
+
+    auto nextLine = [&](size_t from) {
+        const void* eol = std::memchr(data + from, '\n', size - from);
+        if (!eol) {
+            position = size;
+            return false;
+        }
+        position = static_cast<size_t>(static_cast<const char*>(eol) - data) + 1;
+        newLine = true;
+        return true;
+    };
+
+    // С середины строки — к началу следующей
+    if (position > 0 && data[position - 1] != '\n' && !nextLine(position)) return false;
+
+    while (position < size) {
+        size_t first = position;
+        while (first < size && (data[first] == ' ' || data[first] == '\t')) first++;
+        // Метки перед условием: "X: .IF ..." — тоже вложенный блок
+        for (;;) {
+            size_t end = first;
+            while (end < size && (isAlphaNumeric(data[end]) || data[end] == '$')) end++;
+            size_t colon = end;
+            while (colon < size && (data[colon] == ' ' || data[colon] == '\t')) colon++;
+            if (end == first || colon == size || data[colon] != ':') break;
+            first = colon + 1;
+            while (first < size && (data[first] == ' ' || data[first] == '\t')) first++;
+        }
+        if (first < size && data[first] == '.') {
+            size_t length;
+            position = first;
+            if (conditionalAt(length) != Conditional::NONE) return true;
+        }
+        if (!nextLine(first)) return false;
+    }
+    return false;
+}
+
+void Lexer::skipSpaces() {
+    while (peek() == ' ' || peek() == '\t' || peek() == '\r') advance();
+}
+
+std::string_view Lexer::readWord() {
+    size_t start = position;
+    while (isAlphaNumeric(peek()) || peek() == '.') advance();
+    return source.substr(start, position - start);
 }
\ No newline at end of file
@@ -2,8 +2,11 @@
 #define PDP11_LEXER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
 
 // Типы токенов
 enum class TokenType {
@@ -13,12 +16,15 @@ enum class TokenType {
     // Регистры (R0-R7, SP, PC)
     REGISTER,
 
-    // Числовые литералы (десятичные, восьмеричные, шестнадцатеричные)
+    // Числовые литералы: значение уже в Token::number (см. literal.hpp)
     NUMBER,
 
     // Метки (labels)
     LABEL,
 
+    // Строковые литералы ("HELLO"), значение — без кавычек
+    STRING,
+
     // Директивы ассемблера
     DIRECTIVE_WORD,   // .WORD
     DIRECTIVE_BYTE,   // .BYTE
@@ -26,6 +32,15 @@ enum class TokenType {
     DIRECTIVE_EQU,    // .EQU
     DIRECTIVE_ASCII,  // .ASCII
     DIRECTIVE_FILL,   // .FILL
+    DIRECTIVE_RADIX,  // .RADIX
+    DIRECTIVE_ASCIZ,  // .ASCIZ
+    DIRECTIVE_BLKB,   // .BLKB
+    DIRECTIVE_BLKW,   // .BLKW
+    DIRECTIVE_INCBIN, // .INCBIN
+    DIRECTIVE_EVEN,   // .EVEN
+    DIRECTIVE_ODD,    // .ODD
+    DIRECTIVE_PSECT,  // .PSECT
+    DIRECTIVE_CSECT,  // .CSECT
 
     // Символы
     COMMA,        // ,
@@ -39,42 +54,140 @@ enum class TokenType {
 
     // Служебные
     END_OF_FILE,  // Конец файла
-    UNKNOWN       // Неизвестный токен
+    UNKNOWN,      // Неизвестный токен (и неверное число)
+    ERROR         // Ошибка, найденная лексером (текст в value); парсер выдаёт её как есть
 };
 
 // Структура токена
+// Позиция — только смещение в тексте: строку и столбец по нему находит
+// LineIndex, когда они нужны (диагностика, номер строки оператора)
 struct Token {
     TokenType type;
     std::string value;
-    size_t line;
-    size_t column;
+    uint32_t offset = 0;    // Смещение в тексте (тексты до 4 ГБ)
+    uint32_t number = 0;    // Значение NUMBER, переведённое лексером один раз; у ERROR — длина участка
+    bool lineStart = false; // Первый токен строки: по нему парсер видит конец оператора
+};
+
+// Начала строк текста: смещение -> строка и столбец двоичным поиском.
+// Строится одним проходом memchr по тексту (в libc он векторизован),
+// так что лексер не ведёт строку и столбец на каждом байте
+class LineIndex {
+public:
+    // firstLine — номер первой строки, если text — часть файла
+    void build(std::string_view text, size_t firstLine = 1);
+
+    size_t line(uint32_t offset) const;
+    // Для возрастающих смещений (строки statement подряд): поиск вперёд
+    // от прошлой найденной строки hint вместо двоичного
+    size_t line(uint32_t offset, size_t& hint) const;
+    size_t column(uint32_t offset) const; // С 1, в байтах
+    // Столбец в строке, уже найденной line(offset, hint)
+    size_t column(uint32_t offset, size_t hint) const { return offset - starts[hint] + 1; }
+    size_t newlines() const { return starts.size() - 1; }
+
+private:
+    std::vector<uint32_t> starts{0}; // starts[i] — начало строки firstLine + i
+    size_t firstLine = 1;
+
+    size_t index(uint32_t offset) const;
+};
+
+// Условное ассемблирование (.IF/.IFF/.IFT/.IFTF/.ENDC) разбирает сам
+// лексер: строки условий не становятся токенами, а неактивный текст
+// пропускается поиском следующей строки с .IF*/.ENDC, без токенизации.
+// Значения условий известны до раскладки: это определения --define,
+// .EQU с числом и метки, встреченные выше по тексту.
+struct ConditionState {
+    struct Block {
+        bool condition;   // Результат .IF
+        bool outerActive; // Активен ли текст вокруг блока
+        enum class Part { IFT, IFF, IFTF } part = Part::IFT;
+        size_t line = 0;  // Где открыт (для "Missing .ENDC")
+    };
+    std::vector<Block> blocks;
+    std::unordered_map<std::string, int32_t> constants; // --define и .EQU
+    std::unordered_set<std::string> labels;
+    // Имена, которые проверялись в .IF: при тех же начальных значениях
+    // этих имён токены будут те же (см. Assembler::assembleVariants)
+    std::unordered_set<std::string> consulted;
+
+    bool active() const {
+        if (blocks.empty()) return true;
+        const Block& block = blocks.back();
+        if (!block.outerActive) return false;
+        switch (block.part) {
+            case Block::Part::IFT: return block.condition;
+            case Block::Part::IFF: return !block.condition;
+            default:               return true;
+        }
+    }
 };
 
 // Лексер
 class Lexer {
 public:
-    explicit Lexer(const std::string &source);
+    // firstLine — номер первой строки, если source — часть файла
+    explicit Lexer(std::string_view source, size_t firstLine = 1);
     std::vector<Token> tokenize();
+    // Токенизация в переданный буфер (ёмкость буфера переиспользуется)
+    void tokenize(std::vector<Token> &tokens);
+
+    // Система счисления чисел без суффикса: начальная (для части файла —
+    // та, что действовала в конце предыдущей части) и текущая после .RADIX
+    void setRadix(unsigned radix) { initialRadix = radix; }
+    unsigned radix() const { return currentRadix; }
+
+    // Условия: начальное состояние (определения --define или состояние в
+    // конце предыдущей части файла) и состояние после tokenize
+    void setConditions(ConditionState state) { initialConditions = std::move(state); }
+    ConditionState takeConditions() { return std::move(conditions); }
+
+    // Часть файла: незакрытый .IF в конце не ошибка
+    void setPartial(bool value) { partial = value; }
+
+    // Начала строк последнего tokenize (для позиций токенов)
+    const LineIndex& lines() const { return lineIndex; }
+    LineIndex takeLines() { return std::move(lineIndex); }
 
 private:
     char peek() const;
     char advance();
+    Token makeToken(TokenType type, std::string value, size_t start, uint32_t number = 0);
     void skipWhitespace();
     bool isDigit(char c) const;
     bool isAlpha(char c) const;
     bool isAlphaNumeric(char c) const;
 
-    Token parseNumber();
+    Token parseNumber(bool radixArgument);
+    Token parseLocalLabel(size_t digits);
     Token parseIdentifierOrKeyword();
     Token parseLabel();
     Token parseDirective();
-
-    std::string source;
+    Token parseString();
+
+    enum class Conditional { NONE, IF, IFF, IFT, IFTF, ENDC };
+    bool statementStart(const std::vector<Token>& tokens) const;
+    Conditional conditionalAt(size_t& length) const;
+    void parseConditional(Conditional kind, size_t length, std::vector<Token>& tokens);
+    bool evaluateCondition(std::string_view condition, std::string& error);
+    bool skipInactive();
+    void skipSpaces();
+    std::string_view readWord();
+
+    std::string_view source; // Текст не копируется: буфер принадлежит вызывающему
+    size_t firstLine = 1;
     size_t position = 0;
-    size_t line = 1;
-    size_t column = 1;
-
-    const std::unordered_map<std::string, TokenType> keywords = {
+    bool newLine = true;     // С прошлого токена был перевод строки
+    LineIndex lineIndex;
+    unsigned initialRadix = 8;
+    unsigned currentRadix = 8;
+    ConditionState initialConditions;
+    ConditionState conditions;
+    bool partial = false;
+
+    // Таблицы строятся один раз на процесс, а не на каждый экземпляр лексера
+    static inline const std::unordered_map<std::string, TokenType> keywords = {
         {"MOV", TokenType::MOV}, {"CMP", TokenType::CMP}, {"ADD", TokenType::ADD},
         {"SUB", TokenType::SUB}, {"JSR", TokenType::JSR}, {"RTS", TokenType::RTS},
         {"HALT", TokenType::HALT}, {"CLR", TokenType::CLR}, {"COM", TokenType::COM},
@@ -82,13 +195,22 @@ private:
         {"JMP", TokenType::JMP}
     };
 
-    const std::unordered_map<std::string, TokenType> directives = {
+    static inline const std::unordered_map<std::string, TokenType> directives = {
         {".WORD", TokenType::DIRECTIVE_WORD},
         {".BYTE", TokenType::DIRECTIVE_BYTE},
         {".END", TokenType::DIRECTIVE_END},
         {".EQU", TokenType::DIRECTIVE_EQU},
         {".ASCII", TokenType::DIRECTIVE_ASCII},
-        {".FILL", TokenType::DIRECTIVE_FILL}
+        {".FILL", TokenType::DIRECTIVE_FILL},
+        {".RADIX", TokenType::DIRECTIVE_RADIX},
+        {".ASCIZ", TokenType::DIRECTIVE_ASCIZ},
+        {".BLKB", TokenType::DIRECTIVE_BLKB},
+        {".BLKW", TokenType::DIRECTIVE_BLKW},
+        {".INCBIN", TokenType::DIRECTIVE_INCBIN},
+        {".EVEN", TokenType::DIRECTIVE_EVEN},
+        {".ODD", TokenType::DIRECTIVE_ODD},
+        {".PSECT", TokenType::DIRECTIVE_PSECT},
+        {".CSECT", TokenType::DIRECTIVE_CSECT}
     };
 };
 
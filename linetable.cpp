@@ -0,0 +1,104 @@
+#include "linetable.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+static constexpr uint64_t FORMAT_VERSION = 1;
+
+namespace {
+
+void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+uint64_t getVarint(std::string_view bytes, size_t& pos) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= bytes.size()) throw std::runtime_error("truncated line table");
+        uint8_t byte = static_cast<uint8_t>(bytes[pos++]);
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return v;
+    }
+    throw std::runtime_error("invalid line table");
+}
+
+uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+} // namespace
+
+void LineTable::add(uint16_t begin, uint16_t endAddr, size_t line) {
+    if (endAddr <= begin) return;
+    if (!table.empty() && begin > end) {
+        table.push_back({end, 0}); // Пропуск без строки
+    }
+    if (table.empty() || table.back().line != line || begin != end) {
+        table.push_back({begin, static_cast<uint32_t>(line)});
+    }
+    end = endAddr;
+}
+
+void LineTable::clear() {
+    table.clear();
+    end = 0;
+}
+
+uint32_t LineTable::lineFor(uint16_t address) const {
+    if (table.empty() || address < table.front().address || address >= end) return 0;
+    auto it = std::upper_bound(table.begin(), table.end(), address,
+                               [](uint16_t a, const Row& row) { return a < row.address; });
+    return std::prev(it)->line;
+}
+
+std::string LineTable::encode(std::string_view file) const {
+    std::string out = "P11L";
+    putVarint(out, FORMAT_VERSION);
+    putVarint(out, file.size());
+    out += file;
+    putVarint(out, table.size());
+
+    uint16_t address = 0;
+    uint32_t line = 0;
+    for (const auto& row : table) {
+        putVarint(out, row.address - address);
+        putVarint(out, zigzag(static_cast<int64_t>(row.line) - line));
+        address = row.address;
+        line = row.line;
+    }
+    putVarint(out, end - address);
+    return out;
+}
+
+LineTable LineTable::decode(std::string_view bytes, std::string* file) {
+    if (bytes.substr(0, 4) != "P11L") throw std::runtime_error("not a line table");
+    size_t pos = 4;
+    if (getVarint(bytes, pos) != FORMAT_VERSION) throw std::runtime_error("unsupported line table version");
+
+    uint64_t nameLength = getVarint(bytes, pos);
+    if (nameLength > bytes.size() - pos) throw std::runtime_error("truncated line table");
+    if (file) *file = std::string(bytes.substr(pos, nameLength));
+    pos += nameLength;
+
+    LineTable result;
+    uint64_t count = getVarint(bytes, pos);
+    uint64_t address = 0;
+    int64_t line = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        address += getVarint(bytes, pos);
+        line += unzigzag(getVarint(bytes, pos));
+        if (address > 0xFFFF || line < 0) throw std::runtime_error("invalid line table");
+        result.table.push_back({static_cast<uint16_t>(address), static_cast<uint32_t>(line)});
+    }
+    address += getVarint(bytes, pos);
+    if (address > 0xFFFF) throw std::runtime_error("invalid line table");
+    result.end = static_cast<uint16_t>(address);
+    return result;
+}
@@ -0,0 +1,47 @@
+#ifndef PDP11_LINETABLE_HPP
+#define PDP11_LINETABLE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// ========================================================
+// Таблица "адрес -> строка исходника"
+// ========================================================
+// Строка i покрывает адреса [rows[i].address, rows[i+1].address),
+// последняя — до endAddress. line == 0 — слова без строки (пропуск).
+// Формат файла (упрощённая программа строк в духе DWARF):
+//   "P11L" [версия] [длина имени][имя файла] [число строк]
+//   затем для каждой строки: [прирост адреса][прирост номера строки]
+//   и в конце [endAddress - адрес последней строки].
+// Числа — varint (по 7 бит, младшие вперёд), прирост номера строки —
+// zigzag (может быть отрицательным).
+class LineTable {
+public:
+    struct Row {
+        uint16_t address;
+        uint32_t line;
+    };
+
+    // Слова [begin, end) порождены строкой line; вызовы по возрастанию адреса
+    void add(uint16_t begin, uint16_t end, size_t line);
+    void clear();
+
+    const std::vector<Row>& rows() const { return table; }
+    uint16_t endAddress() const { return end; }
+
+    // Строка для адреса; 0 — адрес вне таблицы
+    uint32_t lineFor(uint16_t address) const;
+
+    std::string encode(std::string_view file) const;
+    // Бросает std::runtime_error на повреждённых данных
+    static LineTable decode(std::string_view bytes, std::string* file = nullptr);
+
+private:
+    std::vector<Row> table;
+    uint16_t end = 0;
+};
+
+#endif // PDP11_LINETABLE_HPP
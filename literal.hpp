@@ -0,0 +1,94 @@
+#ifndef PDP11_LITERAL_HPP
+#define PDP11_LITERAL_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// ========================================================
+// Числовые литералы MACRO-11 (общие для Lexer и constexpr_asm.hpp)
+// ========================================================
+//   1234    — в текущей системе счисления (.RADIX, по умолчанию 8)
+//   1234.   — десятичное
+//   0x1F    — шестнадцатеричное, 0o17 — восьмеричное
+// Разбор за один проход по таблице цифр, без исключений и аллокаций.
+// Литерал сам по себе без знака; унарный минус (#-1, .WORD -2) разбирают
+// Parser и constexpr_asm.hpp, а допустимость значения проверяет fits.
+namespace literal {
+
+enum class Status { OK, BAD_DIGIT, OVERFLOW };
+
+struct Result {
+    size_t length = 0;      // Сколько символов занял литерал
+    uint32_t value = 0;
+    Status status = Status::OK;
+};
+
+// Значение символа как цифры (0-35) или 0xFF
+inline constexpr std::array<uint8_t, 256> DIGITS = [] {
+    std::array<uint8_t, 256> table{};
+    for (auto& d : table) d = 0xFF;
+    for (int c = '0'; c <= '9'; c++) table[c] = static_cast<uint8_t>(c - '0');
+    for (int c = 'a'; c <= 'z'; c++) table[c] = static_cast<uint8_t>(c - 'a' + 10);
+    for (int c = 'A'; c <= 'Z'; c++) table[c] = static_cast<uint8_t>(c - 'A' + 10);
+    return table;
+}();
+
+constexpr bool validRadix(uint32_t radix) {
+    return radix == 2 || radix == 8 || radix == 10 || radix == 16;
+}
+
+// Литерал в начале text (text[0] — цифра). Забирается весь хвост из
+// букв и цифр, чтобы "19" при основании 8 было ошибкой, а не "1" и "9"
+constexpr Result parse(std::string_view text, unsigned radix) {
+    Result result;
+    size_t start = 0;
+    unsigned base = radix;
+
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        base = 16;
+        start = 2;
+    } else if (text.size() > 2 && text[0] == '0' && (text[1] == 'o' || text[1] == 'O')) {
+        base = 8;
+        start = 2;
+    }
+
+    size_t end = start;
+    while (end < text.size() && DIGITS[static_cast<uint8_t>(text[end])] != 0xFF) end++;
+    result.length = end;
+
+    // Точка после числа без префикса — десятичная запись
+    if (start == 0 && end < text.size() && text[end] == '.') {
+        base = 10;
+        result.length = end + 1;
+    }
+
+    uint64_t value = 0;
+    for (size_t i = start; i < end; i++) {
+        unsigned digit = DIGITS[static_cast<uint8_t>(text[i])];
+        if (digit >= base) {
+            result.status = Status::BAD_DIGIT;
+            return result;
+        }
+        value = value * base + digit;
+        if (value > 0xFFFFFFFFu) {
+            result.status = Status::OVERFLOW;
+            return result;
+        }
+    }
+    if (end == start) result.status = Status::BAD_DIGIT; // "0x" без цифр
+    result.value = static_cast<uint32_t>(value);
+    return result;
+}
+
+// Помещается ли значение .WORD/.BYTE/#n в bits разрядов: без знака
+// (до 177777 для слова) или со знаком (от -100000), -1 и 177777 —
+// одно и то же слово
+constexpr bool fits(int64_t value, unsigned bits) {
+    return value >= -(int64_t{1} << (bits - 1)) && value < (int64_t{1} << bits);
+}
+
+} // namespace literal
+
+#endif // PDP11_LITERAL_HPP
@@ -1,64 +1,724 @@
-#include "lexer.hpp"
-#include "parser.hpp"
-#include "symtab.hpp"
-#include "codegen.hpp"
+#include "assembler.hpp"
+#include "server.hpp"
+#include "emulator.hpp"
+#include "timing.hpp"
+#include "cache.hpp"
+#include "symfile.hpp"
+#include "profile.hpp"
+#include "compressed.hpp"
+#include "literal.hpp"
+#include "disasm.hpp"
+#include "batchio.hpp"
+#include "probes.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
 
-void saveBinary(const std::string& filename, const std::vector<uint16_t>& code) {
-    std::ofstream out(filename, std::ios::binary);
+// Образ в байтах .bin: слова little-endian
+std::string imageBytes(const std::vector<uint16_t>& code) {
+    std::string bytes;
+    bytes.reserve(code.size() * 2);
     for (auto word : code) {
-        uint8_t bytes[2] = {static_cast<uint8_t>(word & 0xFF), 
-                            static_cast<uint8_t>((word >> 8) & 0xFF)};
-        out.write(reinterpret_cast<const char*>(bytes), 2);
+        bytes.push_back(static_cast<char>(word & 0xFF));
+        bytes.push_back(static_cast<char>((word >> 8) & 0xFF));
+    }
+    return bytes;
+}
+
+void saveBytes(const std::string& filename, std::string_view bytes) {
+    std::ofstream out(filename, std::ios::binary);
+    out.write(bytes.data(), bytes.size());
+}
+
+void saveBinary(const std::string& filename, const std::vector<uint16_t>& code) {
+    saveBytes(filename, imageBytes(code));
+}
+
+std::vector<uint16_t> imageWords(std::string_view bytes) {
+    std::vector<uint16_t> image((bytes.size() + 1) / 2);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        image[i / 2] |= static_cast<uint16_t>(static_cast<uint8_t>(bytes[i]) << (8 * (i % 2)));
+    }
+    return image;
+}
+
+std::string loadBytes(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open " + filename);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+std::vector<uint16_t> loadBinary(const std::string& filename) {
+    return imageWords(loadBytes(filename));
+}
+
+// Формат выходного файла: .bin, сжатый "P11Z" (--compress) или
+// самораспаковывающийся образ с загрузчиком (--loader)
+enum class OutputFormat { RAW, COMPRESSED, LOADER };
+
+// Содержимое выходного файла в выбранном формате
+std::string imageFile(const std::vector<uint16_t>& code, const std::vector<FillRun>& fills, OutputFormat format) {
+    if (format == OutputFormat::RAW) return imageBytes(code);
+    std::string compressed = CompressedImage::encode(code, fills);
+    if (format == OutputFormat::COMPRESSED) return compressed;
+    return imageBytes(CompressedImage::withLoader(compressed));
+}
+
+void saveImage(const std::string& filename, const std::vector<uint16_t>& code,
+               const std::vector<FillRun>& fills, OutputFormat format) {
+    saveBytes(filename, imageFile(code, fills, format));
+}
+
+// NAME или NAME=значение (по умолчанию 1, число восьмеричное, можно с минусом)
+bool parseDefine(std::string_view text, std::string& name, int32_t& value) {
+    size_t eq = text.find('=');
+    name = std::string(text.substr(0, eq));
+    value = 1;
+    if (name.empty()) return false;
+    if (eq == std::string_view::npos) return true;
+
+    std::string_view number = text.substr(eq + 1);
+    bool negative = !number.empty() && number[0] == '-';
+    number.remove_prefix(negative);
+    auto parsed = literal::parse(number, 8);
+    if (number.empty() || parsed.length != number.size() || parsed.status != literal::Status::OK) return false;
+    value = negative ? -static_cast<int32_t>(parsed.value) : static_cast<int32_t>(parsed.value);
+    return true;
+}
+
+// Файл вариантов: строка "имя NAME[=значение]...", ';' — комментарий
+std::vector<Assembler::Variant> loadVariants(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open " + path);
+
+    std::vector<Assembler::Variant> variants;
+    std::string text;
+    for (size_t lineNo = 1; std::getline(in, text); lineNo++) {
+        std::istringstream fields(text.substr(0, text.find(';')));
+        Assembler::Variant variant;
+        if (!(fields >> variant.name)) continue;
+        for (std::string field; fields >> field;) {
+            std::string name;
+            int32_t value;
+            if (!parseDefine(field, name, value)) {
+                throw std::runtime_error(path + ":" + std::to_string(lineNo) + ": invalid definition " + field);
+            }
+            variant.defines[name] = value;
+        }
+        variants.push_back(std::move(variant));
+    }
+    if (variants.empty()) throw std::runtime_error(path + ": no variants");
+    return variants;
+}
+
+// out.bin и вариант rev2 -> out-rev2.bin
+std::string variantPath(const std::string& path, const std::string& variant) {
+    size_t dot = path.rfind('.');
+    size_t slash = path.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = path.size();
+    return path.substr(0, dot) + "-" + variant + path.substr(dot);
+}
+
+// Сборка всех вариантов (--variants): кеш, отчёты и профиль не используются
+int assembleVariants(const std::string& inputPath, const std::string& outputPath, const std::string& source,
+                     const std::vector<Assembler::Variant>& variants, const Assembler::Options& options,
+                     const std::string& symbolsPath, OutputFormat format) {
+    Assembler assembler;
+    auto results = assembler.assembleVariants(source, options, variants);
+
+    int status = 0;
+    size_t programs = 0;
+    for (size_t i = 0; i < variants.size(); i++) {
+        const auto& [result, image, program] = results[i];
+        programs = std::max(programs, program + 1);
+        for (const auto& diag : result.diagnostics) {
+            std::cerr << inputPath << ": " << variants[i].name << ":" << DiagnosticEngine::format(diag) << "\n";
+        }
+        if (!result.success) {
+            status = 1;
+            continue;
+        }
+
+        std::string path = variantPath(outputPath, variants[i].name);
+        try {
+            saveImage(path, image, result.fills, format);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << variants[i].name << ": " << e.what() << "\n";
+            status = 1;
+            continue;
+        }
+        if (!symbolsPath.empty()) {
+            std::vector<SymbolFile::Symbol> table;
+            for (const auto& sym : result.symbols) table.push_back({sym.name, sym.value, sym.is_constant});
+            saveBytes(variantPath(symbolsPath, variants[i].name), SymbolFile::encode(std::move(table)));
+        }
+        std::cout << "Variant " << variants[i].name << ": " << image.size() << " words -> " << path << "\n";
+    }
+    std::cout << "Assembled " << variants.size() << " variants from " << programs << " parses.\n";
+    return status;
+}
+
+// Пакетная сборка (--batch): исходники читаются и образы пишутся пакетом
+// через BatchIO, файлы собираются параллельно (свой Assembler у потока).
+// Образ dir/file.asm — <каталог>/file.bin (.p11z для --compress); кеш не используется
+int assembleBatch(const std::string& outputDir, const std::vector<std::string>& paths,
+                  const Assembler::Options& options, OutputFormat format) {
+    std::vector<std::string> outputPaths(paths.size());
+    std::unordered_map<std::string, size_t> seen;
+    for (size_t i = 0; i < paths.size(); i++) {
+        size_t slash = paths[i].rfind('/');
+        std::string name = paths[i].substr(slash == std::string::npos ? 0 : slash + 1);
+        size_t dot = name.rfind('.');
+        if (dot != std::string::npos && dot > 0) name.resize(dot);
+        outputPaths[i] = outputDir + "/" + name + (format == OutputFormat::COMPRESSED ? ".p11z" : ".bin");
+        auto [it, added] = seen.emplace(outputPaths[i], i);
+        if (!added) {
+            std::cerr << "Error: " << paths[it->second] << " and " << paths[i] << " both write " << outputPaths[i] << "\n";
+            return 1;
+        }
+    }
+
+    BatchIO io;
+    PDP11_PROBE1(phase_start, "read");
+    auto inputs = io.readFiles(paths);
+    PDP11_PROBE2(phase_end, "read", paths.size());
+
+    struct Job {
+        Assembler::Result result;
+        std::string image;
+        std::string error;
+    };
+    std::vector<Job> jobs(paths.size());
+    // Файлы делят ядра: разделам одного файла — доля, а не все ядра
+    unsigned budget = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t threads = std::min<size_t>(paths.size(), budget);
+    Assembler::Options fileOptions = options;
+    fileOptions.threads = static_cast<unsigned>(std::max<size_t>(1, budget / std::max<size_t>(1, threads)));
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        Assembler assembler;
+        std::vector<uint16_t> image;
+        for (size_t i; (i = next.fetch_add(1)) < paths.size();) {
+            if (!inputs[i].error.empty()) continue;
+            PDP11_PROBE2(input, paths[i].c_str(), inputs[i].bytes.size());
+            jobs[i].result = assembler.assemble(inputs[i].bytes, fileOptions, image);
+            if (!jobs[i].result.success) continue;
+            try {
+                jobs[i].image = imageFile(image, jobs[i].result.fills, format);
+            }
+            catch (const std::exception& e) {
+                jobs[i].error = e.what();
+            }
+        }
+    };
+    PDP11_PROBE1(phase_start, "assemble");
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+    PDP11_PROBE2(phase_end, "assemble", paths.size());
+
+    std::vector<BatchIO::Output> outputs;
+    std::vector<size_t> written;
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (jobs[i].result.success && jobs[i].error.empty()) {
+            outputs.push_back({outputPaths[i], jobs[i].image});
+            written.push_back(i);
+        }
+    }
+    PDP11_PROBE1(phase_start, "write");
+    auto writeErrors = io.writeFiles(outputs);
+    PDP11_PROBE2(phase_end, "write", outputs.size());
+    for (size_t k = 0; k < written.size(); k++) jobs[written[k]].error = writeErrors[k];
+
+    size_t failed = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        for (const auto& diag : jobs[i].result.diagnostics) {
+            std::cerr << paths[i] << ":" << DiagnosticEngine::format(diag) << "\n";
+        }
+        std::string error = !inputs[i].error.empty() ? inputs[i].error : jobs[i].error;
+        if (!error.empty()) std::cerr << "Error: " << error << "\n";
+        if (!error.empty() || !jobs[i].result.success) failed++;
+    }
+    std::cout << "Assembled " << paths.size() - failed << " of " << paths.size() << " files ("
+              << io.backend() << ", " << io.syscalls() << " I/O system calls).\n";
+    return failed ? 1 : 0;
+}
+
+// Проверка кругом: исходник -> образ -> Disassembler::listing -> образ,
+// образы должны совпасть бит в бит
+int verifyRoundTrip(const std::vector<std::string>& paths) {
+    Assembler assembler;
+    Assembler::Options options;
+    options.collectSymbols = false;
+    std::vector<uint16_t> original, reassembled;
+    size_t failed = 0, words = 0;
+    double disassemblySeconds = 0;
+
+    for (const auto& path : paths) {
+        std::string source;
+        try {
+            source = loadBytes(path);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            failed++;
+            continue;
+        }
+        auto result = assembler.assemble(source, options, original);
+        if (!result.success) {
+            for (const auto& diag : result.diagnostics) {
+                std::cerr << path << ":" << DiagnosticEngine::format(diag) << "\n";
+            }
+            failed++;
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::string listing = Disassembler::listing(original);
+        disassemblySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        words += original.size();
+
+        auto again = assembler.assemble(listing, options, reassembled);
+        if (!again.success) {
+            std::cerr << path << ": disassembly does not assemble:\n";
+            for (const auto& diag : again.diagnostics) std::cerr << "  " << DiagnosticEngine::format(diag) << "\n";
+            failed++;
+            continue;
+        }
+        if (reassembled != original) {
+            size_t i = std::mismatch(original.begin(), original.end(), reassembled.begin(), reassembled.end()).first -
+                       original.begin();
+            std::cerr << path << ": mismatch at " << std::oct << std::setfill('0') << std::setw(6) << 2 * i;
+            if (i < original.size()) std::cerr << ": " << std::setw(6) << original[i];
+            if (i < reassembled.size()) std::cerr << " became " << std::setw(6) << reassembled[i];
+            std::cerr << std::dec << " (" << original.size() << " vs " << reassembled.size() << " words)\n";
+            failed++;
+            continue;
+        }
+        std::cout << path << ": OK (" << original.size() << " words)\n";
+    }
+
+    std::cout << "Verified " << paths.size() - failed << " of " << paths.size() << " files";
+    if (disassemblySeconds > 0) {
+        std::cout << ", disassembly " << std::fixed << std::setprecision(1)
+                  << 2.0 * words / disassemblySeconds / 1e6 << " MB/s";
+    }
+    std::cout << ".\n";
+    return failed ? 1 : 0;
+}
+
+// Выполнение образа во встроенном эмуляторе (загрузка и старт с адреса 0)
+int runImage(const std::string& filename, uint64_t maxInstructions) {
+    Emulator emulator;
+    emulator.load(loadBinary(filename));
+
+    auto start = std::chrono::steady_clock::now();
+    auto stop = emulator.run(maxInstructions);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << emulator.console;
+    std::cout.flush();
+
+    std::cerr << "Stopped: " << Emulator::stopName(stop) << std::oct << std::setfill('0')
+              << " at PC=" << std::setw(6) << emulator.r[7];
+    if (stop == Emulator::Stop::ODD_ADDRESS || stop == Emulator::Stop::BUS_ERROR ||
+        stop == Emulator::Stop::ILLEGAL_INSTRUCTION) {
+        std::cerr << " (address " << std::setw(6) << emulator.faultAddress << ")";
+    }
+    std::cerr << std::dec << " after " << emulator.executed << " instructions";
+    if (elapsed.count() > 0) {
+        std::cerr << " (" << std::fixed << std::setprecision(1)
+                  << emulator.executed / elapsed.count() / 1e6 << " MIPS)";
+    }
+    std::cerr << "\n" << std::oct;
+    for (int i = 0; i < 8; i++) {
+        std::cerr << (i < 6 ? "R" + std::to_string(i) : (i == 6 ? "SP" : "PC"))
+                  << "=" << std::setw(6) << emulator.r[i] << (i == 7 ? "\n" : " ");
     }
+    std::cerr << "PSW=" << std::setw(3) << emulator.psw << std::dec << "\n";
+
+    return stop == Emulator::Stop::HALT ? 0 : 2;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <input.asm> <output.bin>\n";
+    // Серверный режим: --serve (stdin/stdout) или --serve=<путь к Unix-сокету>
+    if (argc >= 2 && std::string(argv[1]).rfind("--serve", 0) == 0) {
+        std::string arg = argv[1];
+        try {
+            AssemblyServer server;
+            if (arg == "--serve") {
+                server.serveStream(0, 1);
+            } else if (arg.rfind("--serve=", 0) == 0) {
+                server.serveSocket(arg.substr(8));
+            } else {
+                std::cerr << "Unknown option: " << arg << "\n";
+                return 1;
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Запуск образа: --run <image.bin> [лимит команд]
+    if (argc >= 3 && std::string(argv[1]) == "--run") {
+        try {
+            uint64_t limit = argc >= 4 ? std::stoull(argv[3]) : 1000000000ULL;
+            return runImage(argv[2], limit);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Распаковка: --decompress <image.p11z> <image.bin>
+    if (argc == 4 && std::string(argv[1]) == "--decompress") {
+        try {
+            saveBinary(argv[3], CompressedImage::decode(loadBytes(argv[2])));
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Дизассемблирование: --disasm <image.bin> [<out.asm>]
+    if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--disasm") {
+        try {
+            std::string listing = Disassembler::listing(loadBinary(argv[2]));
+            if (argc == 4) saveBytes(argv[3], listing);
+            else std::cout << listing;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Проверка кругом: --verify <file.asm>...
+    if (argc >= 3 && std::string(argv[1]) == "--verify") {
+        return verifyRoundTrip(std::vector<std::string>(argv + 2, argv + argc));
+    }
+
+    // Позиционные аргументы и опции вида --name=value
+    std::vector<std::string> positional;
+    std::string timingName;
+    bool dedupData = false;
+    bool pipeline = false;
+    bool pic = false;
+    OutputFormat format = OutputFormat::RAW;
+    const char* cacheEnv = std::getenv("PDP11_CACHE_DIR");
+    std::string cacheDir = cacheEnv ? cacheEnv : "";
+    std::string symbolsPath;
+    std::vector<std::string> importPaths;
+    std::string lineTablePath;
+    std::string samplesPath;
+    std::unordered_map<std::string, int32_t> defines;
+    std::string variantsPath;
+    std::string batchDir;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--timing=", 0) == 0) {
+            timingName = arg.substr(9);
+        } else if (arg == "--dedup") {
+            dedupData = true;
+        } else if (arg == "--pipeline") {
+            pipeline = true;
+        } else if (arg == "--pic") {
+            pic = true;
+        } else if (arg == "--compress") {
+            format = OutputFormat::COMPRESSED;
+        } else if (arg == "--loader") {
+            format = OutputFormat::LOADER;
+        } else if (arg.rfind("--cache-dir=", 0) == 0) {
+            cacheDir = arg.substr(12);
+        } else if (arg.rfind("--symbols=", 0) == 0) {
+            symbolsPath = arg.substr(10);
+        } else if (arg.rfind("--import-symbols=", 0) == 0) {
+            importPaths.push_back(arg.substr(17));
+        } else if (arg.rfind("--line-table=", 0) == 0) {
+            lineTablePath = arg.substr(13);
+        } else if (arg.rfind("--annotate-profile=", 0) == 0) {
+            samplesPath = arg.substr(19);
+        } else if (arg.rfind("--define=", 0) == 0) {
+            std::string name;
+            int32_t value;
+            if (!parseDefine(arg.substr(9), name, value)) {
+                std::cerr << "Invalid value in " << arg << "\n";
+                return 1;
+            }
+            defines[name] = value;
+        } else if (arg.rfind("--variants=", 0) == 0) {
+            variantsPath = arg.substr(11);
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            batchDir = arg.substr(8);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    // Пакет: позиционные аргументы — исходники
+    if (!batchDir.empty() && !positional.empty()) {
+        if (!timingName.empty() || !symbolsPath.empty() || !lineTablePath.empty() || !samplesPath.empty() ||
+            !variantsPath.empty() || !importPaths.empty()) {
+            std::cerr << "--batch cannot be combined with --timing, --symbols, --line-table, --annotate-profile,"
+                         " --variants or --import-symbols\n";
+            return 1;
+        }
+        Assembler::Options options;
+        options.collectSymbols = false;
+        options.dedupData = dedupData;
+        options.pic = pic;
+        options.collectFills = format != OutputFormat::RAW;
+        options.defines = defines;
+        return assembleBatch(batchDir, positional, options, format);
+    }
+
+    if (positional.size() != 2) {
+        std::cerr << "Usage: " << argv[0] << " <input.asm> <output.bin> [--timing=<cpu>] [--dedup] [--pipeline] [--pic]\n"
+                  << "       " << std::string(std::strlen(argv[0]), ' ')
+                  << " [--cache-dir=<dir>]   (or PDP11_CACHE_DIR)\n"
+                  << "       " << std::string(std::strlen(argv[0]), ' ')
+                  << " [--symbols=<out.sym>] [--import-symbols=<rom.sym>]...\n"
+                  << "       " << std::string(std::strlen(argv[0]), ' ')
+                  << " [--line-table=<out.lines>] [--annotate-profile=<samples.txt>]\n"
+                  << "       " << std::string(std::strlen(argv[0]), ' ')
+                  << " [--compress | --loader] [--define=<name>[=<value>]]...\n"
+                  << "       " << std::string(std::strlen(argv[0]), ' ')
+                  << " [--variants=<file>]   (<output>-<variant>.bin per variant)\n"
+                  << "       " << argv[0] << " --serve[=<socket path>]\n"
+                  << "       " << argv[0] << " --run <image.bin> [max instructions]\n"
+                  << "       " << argv[0] << " --decompress <image.p11z> <image.bin>\n"
+                  << "       " << argv[0] << " --disasm <image.bin> [<out.asm>]\n"
+                  << "       " << argv[0] << " --verify <file.asm>...\n"
+                  << "       " << argv[0] << " --batch=<out dir> <file.asm>... [--dedup] [--pic] [--compress | --loader]\n"
+                  << "       " << std::string(std::strlen(argv[0]), ' ')
+                  << " [--define=<name>[=<value>]]...\n";
+        return 1;
+    }
+    const std::string& inputPath = positional[0];
+    const std::string& outputPath = positional[1];
+
+    const TimingModel* timingModel = nullptr;
+    if (!timingName.empty() && !(timingModel = TimingModel::find(timingName))) {
+        std::cerr << "Unknown CPU model for --timing: " << timingName
+                  << " (known: " << TimingModel::knownModels() << ")\n";
+        return 1;
+    }
+
+    // 1. Чтение исходного файла
+    PDP11_PROBE1(phase_start, "read");
+    std::ifstream file(inputPath);
+    if (!file) {
+        std::cerr << "Error: cannot open " << inputPath << "\n";
         return 1;
     }
+    std::string source((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+    PDP11_PROBE2(phase_end, "read", source.size());
+    PDP11_PROBE2(input, inputPath.c_str(), source.size());
 
+    // Импортируемые символы: файлы отображаются в память и не разбираются
+    std::vector<SymbolFile> imports(importPaths.size());
     try {
-         printf("1. File read\n");
-        // 1. Чтение исходного файла
-        std::ifstream file(argv[1]);
-        std::string source((std::istreambuf_iterator<char>(file)),
-                            std::istreambuf_iterator<char>());
-
-        printf("2. Lexer\n");
-        // 2. Лексический анализ
-        Lexer lexer(source);
-        auto tokens = lexer.tokenize();
-
-        printf("3. Parser\n");
-        // 3. Синтаксический анализ
-        Parser parser(tokens);
-        auto program = parser.parseProgram();
-
-        printf("4. Symtab\n");
-        // 4. Построение таблицы символов
-        SymbolTable symtab;
-        symtab.build(*program);
-
-        printf("5. Codegen\n");
-        // 5. Генерация кода
-        CodeGenerator generator(symtab);
-        auto machine_code = generator.generate(*program);
-        printf("6. Saving bin...\n");
-        
-        // 6. Сохранение результата
-        saveBinary(argv[2], machine_code);
-
-        std::cout << "Successfully generated " << machine_code.size() 
-                  << " words of machine code.\n";
+        for (size_t i = 0; i < importPaths.size(); i++) imports[i].open(importPaths[i]);
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
         return 1;
     }
 
+    // Выборки PC для профиля по строкам
+    std::vector<PcSample> samples;
+    if (!samplesPath.empty()) {
+        try {
+            samples = loadSamples(samplesPath);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    auto annotate = [&](const LineTable& lines) {
+        std::cout << "\n";
+        ProfileReport(lines, source, samples).print(std::cout);
+    };
+
+    // Несколько вариантов: свой путь без кеша и отчётов
+    if (!variantsPath.empty()) {
+        if (timingModel || !lineTablePath.empty() || !samplesPath.empty()) {
+            std::cerr << "--variants cannot be combined with --timing, --line-table or --annotate-profile\n";
+            return 1;
+        }
+        std::vector<Assembler::Variant> variants;
+        try {
+            variants = loadVariants(variantsPath);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        Assembler::Options options;
+        options.collectSymbols = !symbolsPath.empty();
+        options.dedupData = dedupData;
+        options.pic = pic;
+        options.collectFills = format != OutputFormat::RAW;
+        options.defines = defines;
+        for (const auto& file : imports) options.imports.push_back(&file);
+        return assembleVariants(inputPath, outputPath, source, variants, options, symbolsPath, format);
+    }
+
+    // 2. Кеш: при попадании ассемблер не запускается
+    AssemblyCache::Key cacheKey = AssemblyCache::baseKey();
+    cacheKey.add(static_cast<uint64_t>(dedupData)).add(static_cast<uint64_t>(pic)).add(timingName).add(source);
+    for (const auto& file : imports) cacheKey.add(file.bytes());
+    std::map<std::string, int32_t> sortedDefines(defines.begin(), defines.end());
+    for (const auto& [name, value] : sortedDefines) cacheKey.add(name).add(static_cast<uint64_t>(value));
+    AssemblyCache cache(cacheDir);
+    if (!cacheDir.empty()) {
+        AssemblyCache::Entry entry;
+        if (cache.lookup(cacheKey, entry)) {
+            const auto& cached = entry.artifact();
+            std::istringstream diagnostics{std::string(cached.diagnostics)};
+            for (std::string line; std::getline(diagnostics, line);) {
+                std::cerr << inputPath << ":" << line << "\n";
+            }
+            try {
+                saveImage(outputPath, imageWords(cached.image), {}, format);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << "\n";
+                return 1;
+            }
+            if (!symbolsPath.empty()) saveBytes(symbolsPath, cached.symbols);
+            // В кеше таблица без имени файла: те же байты могли прийти под другим путём
+            if (!lineTablePath.empty()) saveBytes(lineTablePath, LineTable::decode(cached.lines).encode(inputPath));
+            std::cout << "Successfully generated " << cached.image.size() / 2
+                      << " words of machine code (cached).\n" << cached.report;
+            if (!samplesPath.empty()) annotate(LineTable::decode(cached.lines));
+            return 0;
+        }
+    }
+
+    // 3. Ассемблирование (лексер, парсер, таблица символов, кодогенерация)
+    Assembler assembler;
+    Assembler::Options options;
+    options.collectInstructions = timingModel != nullptr;
+    options.dedupData = dedupData;
+    options.pipeline = pipeline;
+    options.pic = pic;
+    options.collectLines = !lineTablePath.empty() || !samplesPath.empty() || !cacheDir.empty();
+    options.collectFills = format != OutputFormat::RAW;
+    options.defines = defines;
+    for (const auto& file : imports) options.imports.push_back(&file);
+    std::vector<uint16_t> machine_code;
+    PDP11_PROBE1(phase_start, "assemble");
+    auto result = assembler.assemble(source, options, machine_code);
+    PDP11_PROBE2(phase_end, "assemble", machine_code.size());
+
+    std::string diagnostics;
+    for (const auto& diag : result.diagnostics) {
+        std::string text = DiagnosticEngine::format(diag);
+        std::cerr << inputPath << ":" << text << "\n";
+        diagnostics += text + "\n";
+    }
+    if (!result.success) {
+        return 1;
+    }
+
+    // 4. Сохранение результата
+    PDP11_PROBE1(phase_start, "write");
+    try {
+        saveImage(outputPath, machine_code, result.fills, format);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    PDP11_PROBE2(phase_end, "write", machine_code.size());
+
+    std::cout << "Successfully generated " << machine_code.size()
+              << " words of machine code.\n";
+
+    std::string symbols;
+    if (!symbolsPath.empty() || !cacheDir.empty()) {
+        std::vector<SymbolFile::Symbol> table;
+        table.reserve(result.symbols.size());
+        for (const auto& sym : result.symbols) table.push_back({sym.name, sym.value, sym.is_constant});
+        symbols = SymbolFile::encode(std::move(table));
+    }
+    if (!symbolsPath.empty()) saveBytes(symbolsPath, symbols);
+
+    // В кеш таблица строк идёт без имени файла (в ключе пути нет)
+    std::string lines;
+    if (options.collectLines) lines = result.lines.encode({});
+    if (!lineTablePath.empty()) saveBytes(lineTablePath, result.lines.encode(inputPath));
+
+    // 5. Отчёты (сохраняются в кеш вместе с образом)
+    std::ostringstream report;
+    if (dedupData) {
+        const auto& stats = result.dataStats;
+        report << "Data blocks: " << stats.blocks << ", merged " << stats.merged
+               << ", suffix-shared " << stats.suffixShared << ", dropped " << stats.dropped
+               << ", saved " << stats.bytesSaved << " bytes.\n";
+    }
+    if (result.sections.size() > 1) {
+        report << "Sections:\n" << std::oct << std::setfill('0');
+        for (const auto& section : result.sections) {
+            if (section.size == 0) continue;
+            const auto& attributes = section.attributes;
+            report << "  " << std::left << std::setw(8) << std::setfill(' ') << SectionLayout::title(section.name)
+                   << std::right << std::setfill('0') << " " << std::setw(6) << section.base << " "
+                   << std::setw(6) << section.size << (attributes.readOnly ? " RO" : " RW")
+                   << (attributes.data ? " D" : " I") << (attributes.overlay ? " OVR" : " CON") << "\n";
+        }
+        report << std::dec << std::setfill(' ');
+    }
+    if (pic) {
+        // Адрес слова, строка и откуда адрес метки: загрузчик прибавляет базу
+        if (result.relocations.empty()) {
+            report << "Position-independent: no relocations.\n";
+        } else {
+            report << "Relocations: " << result.relocations.size() << "\n";
+            for (const auto& relocation : result.relocations) {
+                report << "  " << std::oct << std::setfill('0') << std::setw(6) << relocation.address
+                       << std::dec << std::setfill(' ') << "  line " << relocation.line
+                       << (relocation.kind == Relocation::Kind::DATA ? "  data\n" : "  index\n");
+            }
+        }
+    }
+    if (timingModel) {
+        report << "\n";
+        TimingReport(*timingModel, result.instructions).print(report);
+    }
+    std::cout << report.str();
+
+    if (!cacheDir.empty()) {
+        std::string dependencies = AssemblyCache::fingerprint(result.dependencies);
+        std::string image = imageBytes(machine_code);
+        cache.store(cacheKey, {image, symbols, diagnostics, report.str(), lines, dependencies});
+    }
+
+    // 6. Профиль по строкам (не кешируется: зависит от файла выборок)
+    if (!samplesPath.empty()) annotate(result.lines);
+
     return 0;
 }
\ No newline at end of file
@@ -1,33 +1,71 @@
 #include "parser.hpp"
 #include <unordered_map>
-#include <iostream>
+#include "literal.hpp"
+#include "isa.hpp"
+#include "probes.hpp"
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <sys/stat.h>
 
-Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens) {}
+Parser::Parser(const std::vector<Token>& tokens, const LineIndex& lines, DiagnosticEngine& diags)
+    : tokens(tokens), lines(lines), diags(diags) {}
 
 std::unique_ptr<Program> Parser::parseProgram() {
     auto program = ASTBuilder::createProgram();
-    printf("Size: %d \n",tokens.size());
-    while (currentPos < tokens.size() && !match(TokenType::END_OF_FILE)) {
-        try {
-            printf("\nCurrent pos: %d %c %c",currentPos,currentToken().value,peekToken().value);
-            if (auto stmt = parseStatement()) {
-                program->statements.push_back(std::move(stmt));
-            }
-        } catch (const std::runtime_error& e) {
-            // Пропускаем ошибочные statement и пытаемся продолжить
-            while (currentPos < tokens.size() && 
-                  !match(TokenType::END_OF_FILE) &&
-                  currentToken().type != TokenType::LABEL) {
-                advance();
+#ifdef PDP11_DEBUG
+    printf("Size: %zu \n", tokens.size());
+#endif
+    while (!match(TokenType::END_OF_FILE)) {
+#ifdef PDP11_DEBUG
+        printf("\nCurrent pos: %zu %s %s", currentPos,
+               currentToken().value.c_str(), peekToken().value.c_str());
+#endif
+        stmtStart = currentPos;
+        stmtLine = lines.line(currentToken().offset, lineHint);
+        stmtColumn = lines.column(currentToken().offset, lineHint);
+        auto stmt = parseStatement();
+
+        // Statement занимает ровно одну строку
+        if (stmt && !atLineEnd()) {
+            error(currentToken(), "Unexpected '" + currentToken().value + "' after statement");
+            stmt.reset();
+        }
+
+        if (!stmt) {
+            // Ошибка уже в диагностике: продолжаем со следующей строки
+            synchronize();
+            continue;
+        }
+
+        locate(*stmt);
+        PDP11_PROBE2(statement_parsed, stmtLine, currentPos - stmtStart);
+        auto* dir = dynamic_cast<const Directive*>(stmt.get());
+        program->statements.push_back(std::move(stmt));
+
+        // Всё после .END не ассемблируется
+        if (dir && dir->type == Directive::Type::END) {
+            endSeen = true;
+            if (!match(TokenType::END_OF_FILE)) {
+                textAfterEnd = true;
+                diags.warning(range(currentToken(), currentToken().value.size()), "Text after .END ignored");
             }
+            break;
         }
     }
-    
+
     return program;
 }
 
 std::unique_ptr<ASTNode> Parser::parseStatement() {
-    
+    // Ошибка условного ассемблирования, найденная лексером
+    // (в number — длина директивы для подсветки)
+    if (match(TokenType::ERROR)) {
+        const Token& token = currentToken();
+        diags.error(range(token, token.number), token.value);
+        return nullptr;
+    }
+
     // Обработка меток
 
     if (match(TokenType::LABEL) && peekToken().type == TokenType::COLON) {
@@ -49,11 +87,11 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
         {TokenType::NEG, Instruction::Type::NEG},
         {TokenType::JMP, Instruction::Type::JMP}
     };
-    
+
     if (instrMap.count(currentToken().type)) {
         return parseInstruction();
     }
-    
+
     // Обработка директив
     static const std::unordered_map<TokenType, Directive::Type> dirMap = {
         {TokenType::DIRECTIVE_WORD, Directive::Type::WORD},
@@ -62,43 +100,97 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
         {TokenType::DIRECTIVE_END, Directive::Type::END},
         {TokenType::DIRECTIVE_EQU, Directive::Type::EQU},
         {TokenType::DIRECTIVE_FILL, Directive::Type::FILL},
+        {TokenType::DIRECTIVE_RADIX, Directive::Type::RADIX},
+        {TokenType::DIRECTIVE_ASCIZ, Directive::Type::ASCIZ},
+        {TokenType::DIRECTIVE_BLKB, Directive::Type::BLKB},
+        {TokenType::DIRECTIVE_BLKW, Directive::Type::BLKW},
+        {TokenType::DIRECTIVE_INCBIN, Directive::Type::INCBIN},
+        {TokenType::DIRECTIVE_EVEN, Directive::Type::EVEN},
+        {TokenType::DIRECTIVE_ODD, Directive::Type::ODD},
+        {TokenType::DIRECTIVE_PSECT, Directive::Type::PSECT},
+        {TokenType::DIRECTIVE_CSECT, Directive::Type::PSECT},
     };
-    
+
     if (dirMap.count(currentToken().type)) {
         return parseDirective();
     }
-    
-    throw std::runtime_error("Unexpected token: " + currentToken().value);
+
+    if (match(TokenType::LABEL) && !currentToken().value.empty() && currentToken().value[0] == '.') {
+        error(currentToken(), "Unknown directive: " + currentToken().value);
+    } else {
+        error(currentToken(), "Unexpected token: " + currentToken().value);
+    }
+    return nullptr;
 }
 
 std::unique_ptr<Label> Parser::parseLabel() {
     std::string labelName = currentToken().value;
+    uint16_t local = 0;
+    if (!localLabel(currentToken(), local)) return nullptr;
     advance(); // Пропускаем имя метки
-    expect(TokenType::COLON, "Expected ':' after label");
-    
-    // Метка может быть пустой или содержать statement
+    if (!expect(TokenType::COLON, "Expected ':' after label")) return nullptr;
+    advance();
+
+    // Метка может быть пустой или содержать statement на той же строке
     std::unique_ptr<ASTNode> stmt;
-    if (!match(TokenType::END_OF_FILE)) {
+    if (!atLineEnd()) {
         stmt = parseStatement();
+        if (!stmt) return nullptr;
+        locate(*stmt);
     }
-    return ASTBuilder::createLabel(labelName, std::move(stmt));
+    auto label = ASTBuilder::createLabel(labelName, std::move(stmt));
+    label->local = local;
+    return label;
 }
 
 std::unique_ptr<Instruction> Parser::parseInstruction() {
-    auto type = static_cast<Instruction::Type>(currentToken().type);
+    static const std::unordered_map<TokenType, Instruction::Type> typeMap = {
+        {TokenType::MOV, Instruction::Type::MOV}, {TokenType::CMP, Instruction::Type::CMP},
+        {TokenType::ADD, Instruction::Type::ADD}, {TokenType::SUB, Instruction::Type::SUB},
+        {TokenType::JSR, Instruction::Type::JSR}, {TokenType::RTS, Instruction::Type::RTS},
+        {TokenType::HALT, Instruction::Type::HALT}, {TokenType::CLR, Instruction::Type::CLR},
+        {TokenType::COM, Instruction::Type::COM}, {TokenType::INC, Instruction::Type::INC},
+        {TokenType::DEC, Instruction::Type::DEC}, {TokenType::NEG, Instruction::Type::NEG},
+        {TokenType::JMP, Instruction::Type::JMP}
+    };
+    auto type = typeMap.at(currentToken().type);
     advance(); // Пропускаем мнемонику
-    
+
     std::unique_ptr<Operand> src, dst;
-    
+
     // Обработка операндов в зависимости от типа инструкции
-    if (type != Instruction::Type::RTS && 
-        type != Instruction::Type::HALT) {
-        src = parseOperand();
-        
-        if (match(TokenType::COMMA)) {
+    switch (type) {
+        // Двухоперандные: src,dst
+        case Instruction::Type::MOV:
+        case Instruction::Type::CMP:
+        case Instruction::Type::ADD:
+        case Instruction::Type::SUB:
+            if (!(src = parseOperand())) return nullptr;
+            if (!expect(TokenType::COMMA, "Expected ',' between operands")) return nullptr;
             advance();
-            dst = parseOperand();
-        }
+            if (!(dst = parseOperand())) return nullptr;
+            break;
+
+        // JSR R,dst
+        case Instruction::Type::JSR:
+            if (!(src = parseRegister())) return nullptr;
+            if (!expect(TokenType::COMMA, "Expected ',' after link register")) return nullptr;
+            advance();
+            if (!(dst = parseOperand())) return nullptr;
+            break;
+
+        // RTS R
+        case Instruction::Type::RTS:
+            if (!(dst = parseRegister())) return nullptr;
+            break;
+
+        case Instruction::Type::HALT:
+            break;
+
+        // Однооперандные: dst
+        default:
+            if (!(dst = parseOperand())) return nullptr;
+            break;
     }
 
     switch (type) {
@@ -106,229 +198,407 @@ std::unique_ptr<Instruction> Parser::parseInstruction() {
         case Instruction::Type::CMP: return ASTBuilder::createCmp(std::move(src), std::move(dst));
         case Instruction::Type::ADD: return ASTBuilder::createAdd(std::move(src), std::move(dst));
         case Instruction::Type::SUB: return ASTBuilder::createSub(std::move(src), std::move(dst));
-        case Instruction::Type::JSR: return ASTBuilder::createJsr(src->label);
-        case Instruction::Type::RTS: return ASTBuilder::createRts();
+        case Instruction::Type::JSR: return ASTBuilder::createJsr(std::move(src), std::move(dst));
+        case Instruction::Type::RTS: return ASTBuilder::createRts(std::move(dst));
         case Instruction::Type::HALT: return ASTBuilder::createHalt();
         case Instruction::Type::CLR: return ASTBuilder::createClr(std::move(dst));
         case Instruction::Type::COM: return ASTBuilder::createCom(std::move(dst));
         case Instruction::Type::INC: return ASTBuilder::createInc(std::move(dst));
         case Instruction::Type::DEC: return ASTBuilder::createDec(std::move(dst));
         case Instruction::Type::NEG: return ASTBuilder::createNeg(std::move(dst));
-        case Instruction::Type::JMP: return ASTBuilder::createJmp(src->label);
-        default:
-            throw std::runtime_error("Unsupported instruction");
+        case Instruction::Type::JMP:
+            if (dst->mode == AddrMode::REGISTER) {
+                error(tokens[currentPos - 1], "JMP to a register is illegal");
+                return nullptr;
+            }
+            return ASTBuilder::createJmp(std::move(dst));
     }
+    return nullptr;
 }
 
 std::unique_ptr<Directive> Parser::parseDirective() {
-    auto type = static_cast<Directive::Type>(currentToken().type);
+    const Token& dirToken = currentToken();
+    TokenType type = dirToken.type;
     advance(); // Пропускаем директиву
-    
-    std::vector<std::unique_ptr<Operand>> operands;
-    
-    // Парсим операнды директивы
-    while (!match(TokenType::END_OF_FILE)) {
-        operands.push_back(parseOperand());
-        if (!match(TokenType::COMMA)) break;
-        advance();
-    }
-    
+
     switch (type) {
-        case Directive::Type::WORD: return ASTBuilder::createWord(std::move(operands));
-        case Directive::Type::BYTE: return ASTBuilder::createByte(std::move(operands));
-        case Directive::Type::ASCII: {
-            if (operands.empty()) throw std::runtime_error("Expected string for .ASCII");
-            return ASTBuilder::createAscii(operands[0]->label);
+        case TokenType::DIRECTIVE_WORD:
+        case TokenType::DIRECTIVE_BYTE: {
+            auto dir = type == TokenType::DIRECTIVE_WORD ? ASTBuilder::createWord({}) : ASTBuilder::createByte({});
+            if (!parseDataList(*dir)) return nullptr;
+            return dir;
+        }
+        case TokenType::DIRECTIVE_ASCII:
+        case TokenType::DIRECTIVE_ASCIZ: {
+            bool asciz = type == TokenType::DIRECTIVE_ASCIZ;
+            if (!expect(TokenType::STRING, asciz ? "Expected string for .ASCIZ" : "Expected string for .ASCII")) {
+                return nullptr;
+            }
+            std::string text = currentToken().value;
+            advance();
+            return asciz ? ASTBuilder::createAsciz(text) : ASTBuilder::createAscii(text);
+        }
+        case TokenType::DIRECTIVE_INCBIN:
+            return parseIncbin(dirToken);
+        case TokenType::DIRECTIVE_EVEN:
+            return ASTBuilder::createEven();
+        case TokenType::DIRECTIVE_ODD:
+            return ASTBuilder::createOdd();
+        case TokenType::DIRECTIVE_PSECT:
+        case TokenType::DIRECTIVE_CSECT:
+            return parseSection(dirToken);
+        case TokenType::DIRECTIVE_BLKB:
+        case TokenType::DIRECTIVE_BLKW: {
+            // Без аргумента — один байт/слово
+            int count = 1;
+            if (!atLineEnd() && !parseNumber(count)) return nullptr;
+            if (count < 0) {
+                error(dirToken, "Negative block size");
+                return nullptr;
+            }
+            if (!blockFits(dirToken, (type == TokenType::DIRECTIVE_BLKB ? 1u : 2u) * static_cast<size_t>(count))) {
+                return nullptr;
+            }
+            return type == TokenType::DIRECTIVE_BLKB ? ASTBuilder::createBlkb(count) : ASTBuilder::createBlkw(count);
+        }
+        case TokenType::DIRECTIVE_EQU: {
+            if (!expect(TokenType::LABEL, "Expected symbol name for .EQU")) return nullptr;
+            std::string name = currentToken().value;
+            if (isdigit(static_cast<unsigned char>(name[0]))) {
+                error(currentToken(), "Local label cannot be defined with .EQU: " + name);
+                return nullptr;
+            }
+            advance();
+            if (!expect(TokenType::COMMA, "Expected ',' after .EQU symbol")) return nullptr;
+            advance();
+            int value = 0;
+            if (!parseNumber(value)) return nullptr;
+            return ASTBuilder::createEqu(name, value);
         }
-        case Directive::Type::EQU: {
-            if (operands.size() != 2) throw std::runtime_error("Expected label and value for .EQU");
-            return ASTBuilder::createEqu(operands[0]->label, operands[1]->value);
+        case TokenType::DIRECTIVE_END:
+            return ASTBuilder::createEnd();
+        case TokenType::DIRECTIVE_FILL: {
+            int count = 0, value = 0;
+            if (!parseNumber(count)) return nullptr;
+            if (!expect(TokenType::COMMA, "Expected ',' between .FILL count and value")) return nullptr;
+            advance();
+            if (!parseNumber(value)) return nullptr;
+            if (count < 0) {
+                error(dirToken, "Negative .FILL count");
+                return nullptr;
+            }
+            if (!blockFits(dirToken, 2 * static_cast<size_t>(count))) return nullptr;
+            return ASTBuilder::createFill(count, value);
         }
-        case Directive::Type::END: return ASTBuilder::createEnd();
-        case Directive::Type::FILL: {
-            if (operands.size() != 2) throw std::runtime_error("Expected count and value for .FILL");
-            return ASTBuilder::createFill(operands[0]->value, operands[1]->value);
+        case TokenType::DIRECTIVE_RADIX: {
+            // Систему счисления применяет лексер; здесь только проверка
+            int radix = 8;
+            if (!atLineEnd() && !parseNumber(radix)) return nullptr;
+            if (!literal::validRadix(static_cast<uint32_t>(radix))) {
+                error(dirToken, "Invalid .RADIX " + std::to_string(radix) + " (expected 2, 8, 10 or 16)");
+                return nullptr;
+            }
+            return ASTBuilder::createRadix(radix);
         }
         default:
-            throw std::runtime_error("Unsupported directive");
+            error(dirToken, "Unsupported directive: " + dirToken.value);
+            return nullptr;
     }
 }
 
-
-std::unique_ptr<Operand> Parser::parseOperand() {
-    AddrMode mode = parseAddressingMode();
-    auto op = std::make_unique<Operand>();
-    op->mode = mode;
-    switch (mode) {
-        // Регистровый: Rn
-        case AddrMode::REGISTER: {
-            op->reg = currentToken().value;
-            advance();
-            break;
+// .PSECT [имя][, атрибут...] и .CSECT [имя] (без атрибутов).
+// Атрибуты: RO/RW, I/D, CON/OVR и число — выравнивание начала в байтах
+std::unique_ptr<Directive> Parser::parseSection(const Token& dirToken) {
+    std::string name;
+    if (!atLineEnd() && match(TokenType::LABEL)) {
+        name = currentToken().value;
+        if (isdigit(static_cast<unsigned char>(name[0]))) {
+            error(currentToken(), "Local label cannot name a section: " + name);
+            return nullptr;
         }
+        advance();
+    }
+    auto dir = ASTBuilder::createPsect(name);
+    if (dirToken.type == TokenType::DIRECTIVE_CSECT) return dir;
 
-        // Непосредственный: #value
-        case AddrMode::IMMEDIATE: {
-            expect(TokenType::NUMBER, "Expected number after '#'");
-            op->value = std::stoi(currentToken().value);
-            advance();
-            break;
+    SectionAttributes& attributes = dir->attributes;
+    while (!atLineEnd() && match(TokenType::COMMA)) {
+        advance();
+        dir->hasAttributes = true;
+        if (!atLineEnd() && (match(TokenType::NUMBER) ||
+                             (match(TokenType::UNKNOWN) && isdigit(static_cast<unsigned char>(currentToken().value[0]))))) {
+            int align = 0;
+            if (!parseNumber(align)) return nullptr;
+            if (align < 2 || align > 0100000 || (align & (align - 1)) != 0) {
+                error(tokens[currentPos - 1], "Section alignment must be a power of two from 2 to 100000");
+                return nullptr;
+            }
+            attributes.align = static_cast<uint16_t>(align);
+            continue;
         }
-
-        // Относительный: label
-        case AddrMode::RELATIVE: {
-            expect(TokenType::LABEL, "Expected label");
-            op->label = currentToken().value;
-            advance();
-            break;
+        if (!expect(TokenType::LABEL, "Expected section attribute")) return nullptr;
+        const std::string& word = currentToken().value;
+        if (word == "RO" || word == "RW") attributes.readOnly = word == "RO";
+        else if (word == "I" || word == "D") attributes.data = word == "D";
+        else if (word == "CON" || word == "OVR") attributes.overlay = word == "OVR";
+        else {
+            error(currentToken(), "Unknown section attribute: " + word);
+            return nullptr;
         }
+        advance();
+    }
+    return dir;
+}
 
-        // Абсолютный: @#address
-        case AddrMode::ABSOLUTE: {
-            expect(TokenType::NUMBER, "Expected address after '@#'");
-            op->value = std::stoi(currentToken().value);
-            advance();
-            break;
-        }
+// .INCBIN "файл"[, смещение[, длина]] — файл не читается, только stat:
+// размер нужен раскладке, байты скопирует CodeGenerator
+std::unique_ptr<Directive> Parser::parseIncbin(const Token& dirToken) {
+    if (!incbinAllowed) {
+        error(dirToken, ".INCBIN is not allowed: file access is disabled");
+        return nullptr;
+    }
+    if (!expect(TokenType::STRING, "Expected file name for .INCBIN")) return nullptr;
+    const Token& fileToken = currentToken();
+    std::string file = fileToken.value;
+    advance();
 
-        // Косвенно-регистровый: (Rn)
-        case AddrMode::REG_DEF: {
-            expect(TokenType::REGISTER, "Expected register after '('");
-            op->reg = currentToken().value;
-            advance();
-            expect(TokenType::RPAREN, "Expected ')' after register");
+    int offset = 0;
+    int length = -1;
+    if (match(TokenType::COMMA) && !atLineEnd()) {
+        advance();
+        if (!parseNumber(offset)) return nullptr;
+        if (match(TokenType::COMMA) && !atLineEnd()) {
             advance();
-            break;
+            if (!parseNumber(length)) return nullptr;
+            if (length < 0) {
+                error(dirToken, "Negative .INCBIN length");
+                return nullptr;
+            }
         }
+    }
 
-        // Автоинкрементный: (Rn)+
-        case AddrMode::AUTOINC: {
-            expect(TokenType::REGISTER, "Expected register after '('");
-            op->reg = currentToken().value;
-            advance();
-            expect(TokenType::PLUS, "Expected '+' after register");
-            advance();
-            expect(TokenType::RPAREN, "Expected ')' after '+)'");
-            advance();
-            break;
-        }
+    struct stat st;
+    if (::stat(file.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        error(fileToken, "Cannot open .INCBIN file: " + file);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (offset < 0 || static_cast<size_t>(offset) > size) {
+        error(dirToken, ".INCBIN offset outside the file: " + file);
+        return nullptr;
+    }
+    size_t available = size - static_cast<size_t>(offset);
+    if (length >= 0 && static_cast<size_t>(length) > available) {
+        error(dirToken, ".INCBIN range past the end of the file: " + file);
+        return nullptr;
+    }
+    size_t bytes = length < 0 ? available : static_cast<size_t>(length);
+    if (!blockFits(dirToken, bytes)) return nullptr;
+    return ASTBuilder::createIncbin(file, static_cast<size_t>(offset), bytes);
+}
 
-        // Автодекрементный: -(Rn)
-        case AddrMode::AUTODEC: {
-            expect(TokenType::MINUS, "Expected '-'");
-            advance();
-            expect(TokenType::LPAREN, "Expected '(' after '-'");
-            advance();
-            expect(TokenType::REGISTER, "Expected register after '-('");
-            op->reg = currentToken().value;
-            advance();
-            expect(TokenType::RPAREN, "Expected ')' after register");
-            advance();
-            break;
-        }
+// Блок больше адресного пространства не поместится ни с какого адреса.
+// Проверка до раскладки: такой размер не должен дойти до выделения памяти
+// (DataOptimizer, CodeGenerator); выход за 0177777 с учётом адреса
+// проверяет SymbolTable
+bool Parser::blockFits(const Token& dirToken, size_t bytes) {
+    if (bytes <= isa::ADDRESS_SPACE) return true;
+    error(dirToken, "Block of " + std::to_string(bytes) + " bytes does not fit in 64K address space");
+    return false;
+}
+
+// Список значений .WORD/.BYTE через запятую — сразу в data директивы.
+// В .WORD допустимы метки (адрес подставит CodeGenerator)
+bool Parser::parseDataList(Directive& dir) {
+    bool words = dir.type == Directive::Type::WORD;
+    bool first = true;
+    do {
+        if (!first) advance(); // Пропускаем запятую
+        first = false;
 
-        // Индексный: X(Rn)
-        case AddrMode::INDEXED: {
-            // Смещение (может быть числом или меткой)
-            if (match(TokenType::NUMBER)) {
-                op->value = std::stoi(currentToken().value);
-            } else if (match(TokenType::LABEL)) {
-                op->label = currentToken().value;
-            } else {
-                throw std::runtime_error("Expected number or label for offset");
+        if (match(TokenType::LABEL) && !atLineEnd()) {
+            if (!words) {
+                error(currentToken(), "Label not allowed in .BYTE: " + currentToken().value);
+                return false;
             }
+            uint16_t local = 0;
+            if (!localLabel(currentToken(), local)) return false;
+            dir.appendFixup(currentToken().value, local);
             advance();
-            
-            expect(TokenType::LPAREN, "Expected '(' after offset");
-            advance();
-            expect(TokenType::REGISTER, "Expected register in indexed mode");
-            op->reg = currentToken().value;
-            advance();
-            expect(TokenType::RPAREN, "Expected ')' after register");
-            advance();
-            break;
+            continue;
         }
-        default:
-            throw std::runtime_error("Unsupported addressing mode");
+        int value = 0;
+        if (!parseValue(value, words ? 16 : 8)) return false;
+        if (words) dir.appendWord(static_cast<uint16_t>(value));
+        else dir.data.push_back(static_cast<uint8_t>(value));
+    } while (match(TokenType::COMMA) && !atLineEnd());
+    return true;
+}
+
+std::unique_ptr<Operand> Parser::parseRegister() {
+    if (atLineEnd() || !match(TokenType::REGISTER)) {
+        error(currentToken(), "Expected register");
+        return nullptr;
     }
+    auto op = std::make_unique<Operand>();
+    op->mode = AddrMode::REGISTER;
+    op->reg = currentToken().value;
+    advance();
     return op;
 }
-AddrMode Parser::parseAddressingMode() {
-    // Immediate: #value
+
+std::unique_ptr<Operand> Parser::parseOperand() {
+    if (atLineEnd()) {
+        error(currentToken(), "Expected operand");
+        return nullptr;
+    }
+
+    auto op = std::make_unique<Operand>();
+
+    // Непосредственный: #value
     if (match(TokenType::HASH)) {
         advance();
-        return AddrMode::IMMEDIATE;
+        op->mode = AddrMode::IMMEDIATE;
+        if (!parseValue(op->value, 16)) return nullptr;
+        return op;
     }
-    
-    // Absolute: @#address
+
     if (match(TokenType::AT)) {
         advance();
+        // Абсолютный: @#address
         if (match(TokenType::HASH)) {
             advance();
-            return AddrMode::ABSOLUTE;
+            op->mode = AddrMode::ABSOLUTE;
+            if (!parseNumber(op->value)) return nullptr;
+            return op;
+        }
+        // Относительный косвенный: @label или @адрес числом (так его
+        // выводит Disassembler): по адресу лежит адрес операнда
+        op->mode = isa::labelMode(true);
+        if (match(TokenType::NUMBER)) {
+            if (!parseNumber(op->value)) return nullptr;
+            return op;
         }
-        // Relative: @address
-        return AddrMode::RELATIVE;
+        if (!expect(TokenType::LABEL, "Expected label after '@'")) return nullptr;
+        op->label = currentToken().value;
+        if (!localLabel(currentToken(), op->local)) return nullptr;
+        advance();
+        return op;
     }
-    
-    // Register deferred: (Rn)
+
+    // Косвенно-регистровый (Rn) и автоинкрементный (Rn)+
     if (match(TokenType::LPAREN)) {
         advance();
-        expect(TokenType::REGISTER, "Expected register after '('");
-        std::string reg = currentToken().value;
+        if (!expect(TokenType::REGISTER, "Expected register after '('")) return nullptr;
+        op->reg = currentToken().value;
         advance();
-        
-        // Auto-increment: (Rn)+
-        if (match(TokenType::PLUS)) {
-            advance();
-            expect(TokenType::RPAREN, "Expected ')' after '(Rn)+'");
+        if (!expect(TokenType::RPAREN, "Expected ')' after register")) return nullptr;
+        advance();
+        op->mode = AddrMode::REG_DEF;
+        if (match(TokenType::PLUS) && !atLineEnd()) {
             advance();
-            return AddrMode::AUTOINC;
+            op->mode = AddrMode::AUTOINC;
         }
-        
-        expect(TokenType::RPAREN, "Expected ')' after '(Rn)'");
-        advance();
-        return AddrMode::REG_DEF;
+        return op;
     }
-    
-    // Auto-decrement: -(Rn)
+
+    // Автодекрементный: -(Rn)
     if (match(TokenType::MINUS)) {
         advance();
-        expect(TokenType::LPAREN, "Expected '(' after '-'");
+        if (!expect(TokenType::LPAREN, "Expected '(' after '-'")) return nullptr;
         advance();
-        expect(TokenType::REGISTER, "Expected register after '-(Rn)'");
-        std::string reg = currentToken().value;
+        if (!expect(TokenType::REGISTER, "Expected register after '-('")) return nullptr;
+        op->reg = currentToken().value;
         advance();
-        expect(TokenType::RPAREN, "Expected ')' after '-(Rn)'");
+        if (!expect(TokenType::RPAREN, "Expected ')' after register")) return nullptr;
         advance();
-        return AddrMode::AUTODEC;
+        op->mode = AddrMode::AUTODEC;
+        return op;
     }
-    
-    // Indexed: X(Rn)
-    if (match(TokenType::NUMBER)) {
-        int offset = std::stoi(currentToken().value);
+
+    // Регистровый: Rn
+    if (match(TokenType::REGISTER)) {
+        op->mode = AddrMode::REGISTER;
+        op->reg = currentToken().value;
         advance();
-        expect(TokenType::LPAREN, "Expected '(' after number in indexed mode");
+        return op;
+    }
+
+    // Индексный X(Rn), где X — число или метка
+    bool isLabel = match(TokenType::LABEL);
+    if (isLabel || match(TokenType::NUMBER)) {
+        if (isLabel) {
+            op->label = currentToken().value;
+            if (!localLabel(currentToken(), op->local)) return nullptr;
+            advance();
+        } else if (!parseNumber(op->value)) {
+            return nullptr;
+        }
+
+        if (!match(TokenType::LPAREN) || atLineEnd()) {
+            // Относительный: label или адрес числом (так его выводит Disassembler)
+            op->mode = isa::labelMode(false);
+            return op;
+        }
         advance();
-        expect(TokenType::REGISTER, "Expected register in indexed mode");
-        std::string reg = currentToken().value;
+        if (!expect(TokenType::REGISTER, "Expected register in indexed mode")) return nullptr;
+        op->reg = currentToken().value;
         advance();
-        expect(TokenType::RPAREN, "Expected ')' in indexed mode");
+        if (!expect(TokenType::RPAREN, "Expected ')' after register")) return nullptr;
         advance();
-        return AddrMode::INDEXED;
+        op->mode = AddrMode::INDEXED;
+        return op;
     }
-    
-    // Register: Rn
-    if (match(TokenType::REGISTER)) {
-        return AddrMode::REGISTER;
+
+    error(currentToken(), "Unknown addressing mode at '" + currentToken().value + "'");
+    return nullptr;
+}
+
+// Число уже переведено лексером (Token::number)
+bool Parser::parseNumber(int& value) {
+    if (!atLineEnd() && match(TokenType::UNKNOWN) && isdigit(static_cast<unsigned char>(currentToken().value[0]))) {
+        error(currentToken(), "Invalid number: " + currentToken().value);
+        return false;
+    }
+    if (atLineEnd() || !match(TokenType::NUMBER)) {
+        error(currentToken(), "Expected number");
+        return false;
     }
-    
-    // Relative: label
-    if (match(TokenType::LABEL)) {
-        return AddrMode::RELATIVE;
+    if (currentToken().number > static_cast<uint32_t>(INT32_MAX)) {
+        error(currentToken(), "Number out of range: " + currentToken().value);
+        return false;
     }
-    
-    throw std::runtime_error("Unknown addressing mode");
+    value = static_cast<int>(currentToken().number);
+    advance();
+    return true;
+}
+
+// Значение .WORD/.BYTE/#n: число с необязательным минусом. Не влезающее
+// в bits разрядов усекается с предупреждением
+bool Parser::parseValue(int& value, unsigned bits) {
+    bool negative = match(TokenType::MINUS) && !atLineEnd();
+    if (negative) advance();
+    const Token& valueToken = currentToken();
+    if (!parseNumber(value)) return false;
+    if (negative) value = -value;
+    if (!literal::fits(value, bits)) {
+        diags.warning(range(valueToken, valueToken.value.size()),
+                      std::string(bits == 8 ? "Value truncated to byte: " : "Value truncated to word: ") +
+                      (negative ? "-" : "") + valueToken.value);
+    }
+    return true;
+}
+
+// Номер локальной метки n$ (лексер кладёт n в number) или 0 для обычной
+bool Parser::localLabel(const Token& token, uint16_t& local) {
+    local = 0;
+    if (!isdigit(static_cast<unsigned char>(token.value[0]))) return true;
+    if (token.number == 0) {
+        error(token, "Local label out of range (1$-65535$): " + token.value);
+        return false;
+    }
+    local = static_cast<uint16_t>(token.number);
+    return true;
 }
 
 // Вспомогательные методы
@@ -358,9 +628,53 @@ bool Parser::match(TokenType type) {
     return currentToken().type == type;
 }
 
-void Parser::expect(TokenType type, const std::string& errorMsg) {
-    if (!match(type)) {
-        throw std::runtime_error(errorMsg + " at line " + 
-                               std::to_string(currentToken().line));
+// Текущий токен уже не принадлежит строке statement
+bool Parser::atLineEnd() const {
+    return pastStatement(currentToken());
+}
+
+// Токен начинает следующую строку (первый токен statement сам его не завершает)
+bool Parser::pastStatement(const Token& token) const {
+    return token.type == TokenType::END_OF_FILE || (token.lineStart && &token != &tokens[stmtStart]);
+}
+
+// Место оператора: от первого токена statement до последнего разобранного
+void Parser::locate(ASTNode& node) const {
+    const Token& first = tokens[stmtStart];
+    const Token& last = tokens[currentPos > stmtStart ? currentPos - 1 : stmtStart];
+    node.line = stmtLine;
+    node.column = static_cast<uint32_t>(stmtColumn);
+    node.length = last.offset + static_cast<uint32_t>(last.value.size()) - first.offset;
+}
+
+// Строка и столбец ищутся по индексу только для диагностики
+SourceRange Parser::range(const Token& token, size_t length) const {
+    return {lines.line(token.offset), lines.column(token.offset), length};
+}
+
+bool Parser::expect(TokenType type, const char* errorMsg) {
+    if (atLineEnd() || !match(type)) {
+        error(currentToken(), errorMsg);
+        return false;
+    }
+    return true;
+}
+
+void Parser::error(const Token& at, std::string message) {
+    // На конце строки указываем на место после последнего токена строки
+    if (pastStatement(at)) {
+        const Token& last = currentPos > 0 ? tokens[currentPos - 1] : at;
+        SourceRange end = range(last, 0);
+        end.column += last.value.size();
+        diags.error(end, std::move(message));
+        return;
+    }
+    diags.error(range(at, at.value.size()), std::move(message));
+}
+
+// Восстановление после ошибки: пропускаем остаток строки
+void Parser::synchronize() {
+    while (!match(TokenType::END_OF_FILE) && (currentPos == stmtStart || !currentToken().lineStart)) {
+        advance();
     }
 }
\ No newline at end of file
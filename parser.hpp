@@ -3,23 +3,39 @@
 
 #include "lexer.hpp"
 #include "ast.hpp"
+#include "diagnostics.hpp"
 #include <vector>
 #include <memory>
-#include <stdexcept>
 
+// Парсер не бросает исключений: ошибки уходят в DiagnosticEngine,
+// методы разбора возвращают nullptr/false, а parseProgram
+// восстанавливается с начала следующей строки.
 class Parser {
 public:
-    explicit Parser(const std::vector<Token>& tokens);
-    
+    // lines — индекс строк того же текста, что и tokens (Lexer::lines())
+    Parser(const std::vector<Token>& tokens, const LineIndex& lines, DiagnosticEngine& diags);
+
     std::unique_ptr<Program> parseProgram();
 
+    // Разбор остановлен на .END (и был ли после неё текст в этих токенах)
+    bool sawEnd() const { return endSeen; }
+    bool sawTextAfterEnd() const { return textAfterEnd; }
+
+    // false — .INCBIN запрещена (ошибка разбора, файл не трогается)
+    void setIncbinAllowed(bool allowed) { incbinAllowed = allowed; }
+
 private:
     // Вспомогательные методы
     const Token& currentToken() const;
     const Token& peekToken() const;
     void advance();
     bool match(TokenType type);
-    void expect(TokenType type, const std::string& errorMsg);
+    bool expect(TokenType type, const char* errorMsg);
+    bool atLineEnd() const;
+    bool pastStatement(const Token& token) const;
+    SourceRange range(const Token& token, size_t length) const;
+    void error(const Token& at, std::string message);
+    void synchronize();
 
     // Методы парсинга
     std::unique_ptr<ASTNode> parseStatement();
@@ -27,10 +43,27 @@ private:
     std::unique_ptr<Instruction> parseInstruction();
     std::unique_ptr<Directive> parseDirective();
     std::unique_ptr<Operand> parseOperand();
-    AddrMode parseAddressingMode();
+    std::unique_ptr<Operand> parseRegister();
+    bool parseDataList(Directive& dir);
+    std::unique_ptr<Directive> parseIncbin(const Token& dirToken);
+    std::unique_ptr<Directive> parseSection(const Token& dirToken);
+    bool parseNumber(int& value);
+    bool parseValue(int& value, unsigned bits);
+    bool blockFits(const Token& dirToken, size_t bytes);
+    bool localLabel(const Token& token, uint16_t& local);
+    void locate(ASTNode& node) const;
 
-    std::vector<Token> tokens;
+    const std::vector<Token>& tokens; // Токены не копируются: буфер принадлежит вызывающему
+    const LineIndex& lines;
+    DiagnosticEngine& diags;
     size_t currentPos = 0;
+    size_t stmtStart = 0;             // Первый токен разбираемого statement
+    size_t stmtLine = 0;              // Его строка
+    size_t stmtColumn = 0;            // И столбец
+    size_t lineHint = 0;              // Для LineIndex::line: statement идут по возрастанию
+    bool endSeen = false;
+    bool textAfterEnd = false;
+    bool incbinAllowed = true;
 };
 
 #endif // PDP11_PARSER_HPP
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "pipeline.hpp"
+#include "spsc_queue.hpp"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using Statements = std::vector<std::unique_ptr<ASTNode>>;
+
+// Кусок после лексера: токены и строки куска (смещения токенов — от его начала)
+struct LexedChunk {
+    std::vector<Token> tokens;
+    LineIndex lines;
+};
+
+std::unique_ptr<Program> AssemblyPipeline::run(std::string_view source, DiagnosticEngine& diags,
+                                               SymbolTable& symtab, std::exception_ptr& layoutError,
+                                               ConditionState conditions, bool allowIncbin) {
+    SpscQueue<LexedChunk, QUEUE_DEPTH> tokenQueue;
+    SpscQueue<Statements, QUEUE_DEPTH> statementQueue;
+
+    // 1. Лексер: куски по BATCH_BYTES, дотянутые до конца строки
+    std::thread lexerStage([&] {
+        size_t pos = 0;
+        size_t line = 1;
+        unsigned radix = 8; // .RADIX и открытые .IF действуют и в следующих кусках
+        while (pos < source.size()) {
+            size_t end = std::min(pos + BATCH_BYTES, source.size());
+            if (end < source.size()) {
+                end = source.find('\n', end);
+                end = end == std::string_view::npos ? source.size() : end + 1;
+            }
+            std::string_view chunk = source.substr(pos, end - pos);
+
+            LexedChunk lexed;
+            Lexer lexer(chunk, line);
+            lexer.setRadix(radix);
+            lexer.setConditions(std::move(conditions));
+            lexer.setPartial(end < source.size());
+            lexer.tokenize(lexed.tokens);
+            radix = lexer.radix();
+            conditions = lexer.takeConditions();
+            lexed.lines = lexer.takeLines();
+            line += lexed.lines.newlines();
+            tokenQueue.push(std::move(lexed));
+
+            pos = end;
+        }
+        tokenQueue.close();
+    });
+
+    // 2. Парсер: каждый кусок разбирается отдельно, диагностика общая
+    //    (другие стадии в неё не пишут)
+    std::thread parserStage([&] {
+        bool ended = false;
+        bool warned = false;
+        LexedChunk lexed;
+        while (tokenQueue.pop(lexed)) {
+            const auto& tokens = lexed.tokens;
+            if (ended) {
+                // Текст после .END в следующих кусках: одно предупреждение
+                if (!warned && tokens.size() > 1) {
+                    const Token& first = tokens.front();
+                    diags.warning({lexed.lines.line(first.offset), lexed.lines.column(first.offset), first.value.size()},
+                                  "Text after .END ignored");
+                    warned = true;
+                }
+                continue;
+            }
+
+            Parser parser(tokens, lexed.lines, diags);
+            parser.setIncbinAllowed(allowIncbin);
+            auto part = parser.parseProgram();
+            ended = parser.sawEnd();
+            warned = parser.sawTextAfterEnd();
+            statementQueue.push(std::move(part->statements));
+        }
+        statementQueue.close();
+    });
+
+    // 3. Раскладка адресов в вызывающем потоке
+    auto program = ASTBuilder::createProgram();
+    symtab.begin();
+    Statements batch;
+    while (statementQueue.pop(batch)) {
+        for (auto& stmt : batch) {
+            // После ошибки только дочитываем очередь, чтобы стадии завершились
+            if (!layoutError) {
+                try {
+                    symtab.add(*stmt);
+                }
+                catch (const std::exception&) {
+                    layoutError = std::current_exception();
+                }
+            }
+            program->statements.push_back(std::move(stmt));
+        }
+    }
+
+    lexerStage.join();
+    parserStage.join();
+    return program;
+}
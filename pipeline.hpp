@@ -0,0 +1,38 @@
+#ifndef PDP11_PIPELINE_HPP
+#define PDP11_PIPELINE_HPP
+
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "symtab.hpp"
+#include "diagnostics.hpp"
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// ========================================================
+// Конвейер: лексер, парсер и раскладка адресов одновременно
+// ========================================================
+//   поток 1: Lexer по кускам исходника (границы — концы строк)
+//        -> SpscQueue<токены куска>
+//   поток 2: Parser по каждому куску (оператор занимает одну строку)
+//        -> SpscQueue<операторы куска>
+//   вызывающий поток: SymbolTable::add по мере поступления
+// Кодирование начинается после finish(): адреса вперёд нужны
+// CodeGenerator сразу, а сам проход кодирования самый дешёвый.
+class AssemblyPipeline {
+public:
+    static constexpr size_t BATCH_BYTES = 64 * 1024; // Размер куска исходника
+    static constexpr size_t QUEUE_DEPTH = 16;        // Кусков в пути между стадиями
+
+    // Ошибки разбора — в diags; ошибка раскладки (повтор метки и т.п.) —
+    // в layoutError (исключение с местом оператора). Таблица должна быть очищена (и импорт задан) заранее;
+    // SymbolTable::finish вызывает вызывающий. conditions — начальное
+    // состояние условий (определения --define), переходит из куска в кусок.
+    // allowIncbin — см. Parser::setIncbinAllowed.
+    std::unique_ptr<Program> run(std::string_view source, DiagnosticEngine& diags,
+                                 SymbolTable& symtab, std::exception_ptr& layoutError,
+                                 ConditionState conditions = {}, bool allowIncbin = true);
+};
+
+#endif // PDP11_PIPELINE_HPP
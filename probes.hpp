@@ -0,0 +1,99 @@
+#ifndef PDP11_PROBES_HPP
+#define PDP11_PROBES_HPP
+
+#include <cstdint>
+#include <type_traits>
+
+// ========================================================
+// Статические точки трассировки USDT (провайдер pdp11)
+// ========================================================
+// Точка — одна команда nop в коде и запись в секции .note.stapsdt, где
+// указаны её адрес и расположение аргументов. perf, bpftrace и SystemTap
+// находят точки в готовом бинарнике, пересборка не нужна:
+//   bpftrace -e 'usdt:./asm:pdp11:phase_end { printf("%s %d\n", str(arg0), arg1); }'
+//   perf buildid-cache --add ./asm && perf record -e sdt_pdp11:statement_parsed ...
+// Пока точка не включена, цена — nop и вычисление аргументов в регистры.
+//
+// Точки:
+//   input(path, bytes)                      — начало сборки файла
+//   phase_start(name)                       — начало фазы (строка)
+//   phase_end(name, count)                  — конец фазы; count — байты,
+//                                             токены, операторы или слова
+//   statement_parsed(line, tokens)          — оператор разобран
+//   statement_encoded(line, address, words) — оператор закодирован
+//
+// С sys/sdt.h записи делает он; без него — свой ассемблерный шаблон того
+// же формата (x86-64). -DPDP11_NO_PROBES или другая платформа — пустые
+// макросы, аргументы не вычисляются.
+namespace probes {
+template <typename T>
+inline int64_t arg(T value) {
+    if constexpr (std::is_pointer_v<T>) {
+        return static_cast<int64_t>(reinterpret_cast<intptr_t>(value));
+    } else {
+        return static_cast<int64_t>(value);
+    }
+}
+} // namespace probes
+
+#if defined(PDP11_NO_PROBES)
+
+#define PDP11_PROBE1(name, a) ((void)0)
+#define PDP11_PROBE2(name, a, b) ((void)0)
+#define PDP11_PROBE3(name, a, b, c) ((void)0)
+
+#elif __has_include(<sys/sdt.h>)
+
+#include <sys/sdt.h>
+#define PDP11_PROBE1(name, a) DTRACE_PROBE1(pdp11, name, probes::arg(a))
+#define PDP11_PROBE2(name, a, b) DTRACE_PROBE2(pdp11, name, probes::arg(a), probes::arg(b))
+#define PDP11_PROBE3(name, a, b, c) \
+    DTRACE_PROBE3(pdp11, name, probes::arg(a), probes::arg(b), probes::arg(c))
+
+#elif defined(__x86_64__) && defined(__ELF__) && defined(__GNUC__)
+
+// Запись stapsdt (версия 3): адрес nop, адрес .stapsdt.base (по нему
+// отладчик учитывает сдвиг при prelink), семафор (нет), провайдер, имя
+// и аргументы вида "-8@%rax" — знаковые 8 байт в операнде ассемблера
+#define PDP11_PROBE_NOTE(name, args)                                          \
+    "990: nop\n"                                                              \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                             \
+    ".balign 4\n"                                                             \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                        \
+    "991: .asciz \"stapsdt\"\n"                                               \
+    "992: .balign 4\n"                                                        \
+    "993: .8byte 990b\n"                                                      \
+    ".8byte _.stapsdt.base\n"                                                 \
+    ".8byte 0\n"                                                              \
+    ".asciz \"pdp11\"\n"                                                      \
+    ".asciz \"" #name "\"\n"                                                  \
+    ".asciz \"" args "\"\n"                                                   \
+    "994: .balign 4\n"                                                        \
+    ".popsection\n"                                                           \
+    ".ifndef _.stapsdt.base\n"                                                \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"   \
+    ".weak _.stapsdt.base\n"                                                  \
+    ".hidden _.stapsdt.base\n"                                                \
+    "_.stapsdt.base: .space 1\n"                                              \
+    ".size _.stapsdt.base, 1\n"                                               \
+    ".popsection\n"                                                           \
+    ".endif\n"
+
+#define PDP11_PROBE1(name, a) \
+    __asm__ __volatile__(PDP11_PROBE_NOTE(name, "-8@%0") :: "nor"(probes::arg(a)))
+#define PDP11_PROBE2(name, a, b)                                       \
+    __asm__ __volatile__(PDP11_PROBE_NOTE(name, "-8@%0 -8@%1")          \
+                         :: "nor"(probes::arg(a)), "nor"(probes::arg(b)))
+#define PDP11_PROBE3(name, a, b, c)                                    \
+    __asm__ __volatile__(PDP11_PROBE_NOTE(name, "-8@%0 -8@%1 -8@%2")    \
+                         :: "nor"(probes::arg(a)), "nor"(probes::arg(b)), "nor"(probes::arg(c)))
+
+#else
+
+#define PDP11_PROBE1(name, a) ((void)0)
+#define PDP11_PROBE2(name, a, b) ((void)0)
+#define PDP11_PROBE3(name, a, b, c) ((void)0)
+
+#endif
+
+#endif // PDP11_PROBES_HPP
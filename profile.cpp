@@ -0,0 +1,80 @@
+#include "profile.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<PcSample> loadSamples(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot open " + path);
+
+    std::vector<PcSample> samples;
+    std::string text;
+    for (size_t lineNo = 1; std::getline(in, text); lineNo++) {
+        text = text.substr(0, text.find_first_of(";#"));
+        std::istringstream fields(text);
+        unsigned long address;
+        if (!(fields >> std::oct >> address)) {
+            if (text.find_first_not_of(" \t\r") == std::string::npos) continue;
+            throw std::runtime_error(path + ":" + std::to_string(lineNo) + ": expected octal address");
+        }
+        unsigned long long count = 1;
+        fields >> std::dec >> count;
+        if (address > 0xFFFF) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNo) + ": address out of range");
+        }
+        samples.push_back({static_cast<uint16_t>(address), count});
+    }
+    return samples;
+}
+
+ProfileReport::ProfileReport(const LineTable& lines, std::string_view source,
+                             const std::vector<PcSample>& samples) {
+    for (size_t pos = 0; pos < source.size();) {
+        size_t eol = source.find('\n', pos);
+        if (eol == std::string_view::npos) eol = source.size();
+        sourceLines.push_back(source.substr(pos, eol - pos));
+        pos = eol + 1;
+    }
+    lineCounts.assign(sourceLines.size() + 1, 0);
+
+    for (const auto& sample : samples) {
+        total += sample.count;
+        uint32_t line = lines.lineFor(sample.address);
+        if (line == 0 || line >= lineCounts.size()) unmapped += sample.count;
+        else lineCounts[line] += sample.count;
+    }
+}
+
+void ProfileReport::print(std::ostream& out, size_t hottest) const {
+    auto flags = out.flags();
+    auto percent = [&](uint64_t n) { return total ? 100.0 * n / total : 0.0; };
+
+    out << "Profile: " << total << " samples";
+    if (unmapped) out << ", " << unmapped << " outside the program";
+    out << "\n\n  Samples      %   Line  Source\n" << std::fixed << std::setprecision(1);
+
+    for (size_t line = 1; line < lineCounts.size(); line++) {
+        uint64_t n = lineCounts[line];
+        if (n) out << std::setw(9) << n << std::setw(7) << percent(n);
+        else out << std::setw(16) << "";
+        out << std::setw(7) << line << "  " << sourceLines[line - 1] << "\n";
+    }
+
+    std::vector<size_t> order;
+    for (size_t line = 1; line < lineCounts.size(); line++) {
+        if (lineCounts[line]) order.push_back(line);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return lineCounts[a] > lineCounts[b]; });
+    if (order.size() > hottest) order.resize(hottest);
+
+    out << "\nHottest lines:\n";
+    for (size_t line : order) {
+        out << std::setw(9) << lineCounts[line] << std::setw(7) << percent(lineCounts[line])
+            << std::setw(7) << line << "  " << sourceLines[line - 1] << "\n";
+    }
+
+    out.flags(flags);
+}
@@ -0,0 +1,37 @@
+#ifndef PDP11_PROFILE_HPP
+#define PDP11_PROFILE_HPP
+
+#include "linetable.hpp"
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// ========================================================
+// Профиль по строкам исходника из выборок PC
+// ========================================================
+// Файл выборок: по строке на адрес, "адрес [число]", адрес восьмеричный
+// (как на консоли PDP-11), число по умолчанию 1; ';' и '#' — комментарии.
+struct PcSample {
+    uint16_t address;
+    uint64_t count;
+};
+
+std::vector<PcSample> loadSamples(const std::string& path);
+
+// Листинг с числом выборок на строку и список самых горячих строк
+class ProfileReport {
+public:
+    ProfileReport(const LineTable& lines, std::string_view source, const std::vector<PcSample>& samples);
+
+    void print(std::ostream& out, size_t hottest = 10) const;
+
+private:
+    std::vector<std::string_view> sourceLines;
+    std::vector<uint64_t> lineCounts; // Индекс — номер строки (с 1)
+    uint64_t total = 0;
+    uint64_t unmapped = 0;            // Выборки вне таблицы строк
+};
+
+#endif // PDP11_PROFILE_HPP
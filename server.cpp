@@ -0,0 +1,143 @@
+#include "server.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+namespace {
+
+// Чтение ровно size байт; false — поток закончился
+bool readFull(int fd, void* buf, size_t size) {
+    auto* p = static_cast<uint8_t*>(buf);
+    while (size > 0) {
+        ssize_t n = ::read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool writeFull(int fd, const void* buf, size_t size) {
+    auto* p = static_cast<const uint8_t*>(buf);
+    while (size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>(v & 0xFF));
+    out.push_back(static_cast<uint8_t>((v >> 8) & 0xFF));
+    out.push_back(static_cast<uint8_t>((v >> 16) & 0xFF));
+    out.push_back(static_cast<uint8_t>((v >> 24) & 0xFF));
+}
+
+} // namespace
+
+void AssemblyServer::serveStream(int in_fd, int out_fd) {
+    // Запись в закрытый клиентом канал — EPIPE, а не завершение процесса
+    ::signal(SIGPIPE, SIG_IGN);
+    while (handleRequest(in_fd, out_fd)) {
+    }
+}
+
+void AssemblyServer::serveSocket(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error("socket() failed: " + std::string(strerror(errno)));
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    // Остаток прошлого запуска убирается, чужой файл — ошибка
+    struct stat st;
+    if (::lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            ::close(listen_fd);
+            throw std::runtime_error("Cannot listen on " + path + ": file exists and is not a socket");
+        }
+        ::unlink(path.c_str());
+    }
+
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd, 16) < 0) {
+        std::string err = strerror(errno);
+        ::close(listen_fd);
+        throw std::runtime_error("Cannot listen on " + path + ": " + err);
+    }
+
+    for (;;) {
+        int client = ::accept(listen_fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        serveStream(client, client);
+        ::close(client);
+    }
+
+    ::close(listen_fd);
+    ::unlink(path.c_str());
+}
+
+bool AssemblyServer::handleRequest(int in_fd, int out_fd) {
+    uint8_t header[4];
+    if (!readFull(in_fd, header, sizeof(header))) return false;
+
+    uint32_t length = header[0] | (header[1] << 8) | (header[2] << 16) |
+                      (static_cast<uint32_t>(header[3]) << 24);
+    if (length == 0) return false;
+    if (length > MAX_REQUEST) {
+        image.clear();
+        diagnostics = "error: Request too large: " + std::to_string(length) + " bytes (limit " +
+                      std::to_string(MAX_REQUEST) + ")\n";
+        sendResponse(out_fd, false);
+        return false;
+    }
+
+    source.resize(length);
+    if (!readFull(in_fd, source.data(), length)) return false;
+
+    Assembler::Options options;
+    options.collectSymbols = false;
+    options.allowIncbin = false;
+    auto result = assembler.assemble(source, options, image);
+
+    diagnostics.clear();
+    for (const auto& diag : result.diagnostics) {
+        diagnostics += DiagnosticEngine::format(diag);
+        diagnostics += "\n";
+    }
+    return sendResponse(out_fd, result.success);
+}
+
+bool AssemblyServer::sendResponse(int out_fd, bool ok) {
+    // Ответ собирается в один буфер и уходит одним write
+    response.clear();
+    putU32(response, ok ? 0 : 1);
+    putU32(response, static_cast<uint32_t>(image.size() * 2));
+    for (auto word : image) {
+        response.push_back(static_cast<uint8_t>(word & 0xFF));
+        response.push_back(static_cast<uint8_t>((word >> 8) & 0xFF));
+    }
+    putU32(response, static_cast<uint32_t>(diagnostics.size()));
+    response.insert(response.end(), diagnostics.begin(), diagnostics.end());
+
+    return writeFull(out_fd, response.data(), response.size());
+}
@@ -0,0 +1,44 @@
+#ifndef PDP11_SERVER_HPP
+#define PDP11_SERVER_HPP
+
+#include "assembler.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// ========================================================
+// Долгоживущий режим ассемблера (--serve)
+// ========================================================
+// Протокол (все числа — uint32, little-endian):
+//   запрос: [длина исходника][текст исходника]
+//   ответ:  [статус 0/1][длина образа в байтах][образ]
+//           [длина диагностики][текст диагностики]
+// Запрос нулевой длины или конец потока завершают сессию. Исходник
+// длиннее MAX_REQUEST не читается: ответ с ошибкой и конец сессии.
+// Клиент, ушедший не дочитав ответ, завершает только свою сессию.
+// .INCBIN в запросах запрещена: иначе любой клиент сокета читает файлы
+// с правами сервера. Сокет создаётся заново; на месте пути допускается
+// только старый сокет, другой файл не удаляется.
+class AssemblyServer {
+public:
+    static constexpr uint32_t MAX_REQUEST = 64u << 20;
+
+    // Обслуживание запросов из in_fd с ответами в out_fd (stdin/stdout)
+    void serveStream(int in_fd, int out_fd);
+
+    // Обслуживание клиентов локального Unix-сокета (по одному за раз)
+    void serveSocket(const std::string& path);
+
+private:
+    bool handleRequest(int in_fd, int out_fd);
+    bool sendResponse(int out_fd, bool ok);
+
+    // Буферы переиспользуются между запросами
+    Assembler assembler;
+    std::string source;
+    std::vector<uint16_t> image;
+    std::string diagnostics;
+    std::vector<uint8_t> response;
+};
+
+#endif // PDP11_SERVER_HPP
@@ -0,0 +1,76 @@
+#ifndef PDP11_SPSC_QUEUE_HPP
+#define PDP11_SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+
+// ========================================================
+// Ограниченная очередь: один производитель, один потребитель
+// ========================================================
+// Кольцевой буфер без блокировок. Индексы head/tail лежат в разных
+// строках кеша; каждая сторона держит копию чужого индекса и
+// перечитывает атомик, только когда копия говорит "полно"/"пусто".
+// Ожидание — короткий спин, затем yield (стадии конвейера живут
+// недолго, засыпать на futex нет смысла).
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    // Производитель: блокируется, пока есть место
+    void push(T&& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        for (unsigned spins = 0; t - cachedHead == Capacity; spins++) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == Capacity) wait(spins);
+        }
+        slots[t & (Capacity - 1)] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+    }
+
+    // Производитель: больше элементов не будет
+    void close() {
+        closed.store(true, std::memory_order_release);
+    }
+
+    // Потребитель: false — очередь закрыта и пуста
+    bool pop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        for (unsigned spins = 0; h == cachedTail; spins++) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h != cachedTail) break;
+            if (closed.load(std::memory_order_acquire)) {
+                // close() после последнего push: перечитываем tail
+                cachedTail = tail.load(std::memory_order_acquire);
+                if (h == cachedTail) return false;
+                break;
+            }
+            wait(spins);
+        }
+        value = std::move(slots[h & (Capacity - 1)]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static void wait(unsigned spins) {
+        if (spins >= 64) std::this_thread::yield();
+    }
+
+    // Сторона потребителя
+    alignas(64) std::atomic<size_t> head{0};
+    size_t cachedTail = 0;
+
+    // Сторона производителя
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t cachedHead = 0;
+
+    alignas(64) std::atomic<bool> closed{false};
+    std::array<T, Capacity> slots;
+};
+
+#endif // PDP11_SPSC_QUEUE_HPP
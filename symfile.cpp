@@ -0,0 +1,189 @@
+#include "symfile.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static constexpr uint32_t FORMAT_VERSION = 1;
+static constexpr size_t HEADER_SIZE = 20;
+static constexpr size_t ENTRY_SIZE = 12;
+
+namespace {
+
+uint16_t getU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void putU16(std::string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>(v >> 8));
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+} // namespace
+
+// ========================================================
+// 1. Запись
+// ========================================================
+std::string SymbolFile::encode(std::vector<Symbol> symbols) {
+    std::sort(symbols.begin(), symbols.end(),
+              [](const Symbol& a, const Symbol& b) { return a.name < b.name; });
+
+    std::vector<uint32_t> byAddress;
+    for (uint32_t i = 0; i < symbols.size(); i++) {
+        if (!symbols[i].is_constant) byAddress.push_back(i);
+    }
+    std::stable_sort(byAddress.begin(), byAddress.end(),
+                     [&](uint32_t a, uint32_t b) { return symbols[a].value < symbols[b].value; });
+
+    std::string pool;
+    for (const auto& sym : symbols) pool += sym.name;
+
+    std::string out = "P11S";
+    putU32(out, FORMAT_VERSION);
+    putU32(out, static_cast<uint32_t>(symbols.size()));
+    putU32(out, static_cast<uint32_t>(byAddress.size()));
+    putU32(out, static_cast<uint32_t>(pool.size()));
+
+    uint32_t offset = 0;
+    for (const auto& sym : symbols) {
+        putU32(out, offset);
+        putU16(out, static_cast<uint16_t>(sym.name.size()));
+        putU16(out, sym.value);
+        putU16(out, sym.is_constant ? CONSTANT : 0);
+        putU16(out, 0);
+        offset += static_cast<uint32_t>(sym.name.size());
+    }
+    for (auto index : byAddress) putU32(out, index);
+    out += pool;
+    return out;
+}
+
+// ========================================================
+// 2. Чтение (mmap)
+// ========================================================
+SymbolFile::SymbolFile(SymbolFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+SymbolFile& SymbolFile::operator=(SymbolFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        base = other.base;
+        length = other.length;
+        count = other.count;
+        addressCount = other.addressCount;
+        entries = other.entries;
+        addresses = other.addresses;
+        strings = other.strings;
+        stringsSize = other.stringsSize;
+        other.base = nullptr;
+        other.length = 0;
+        other.count = other.addressCount = 0;
+    }
+    return *this;
+}
+
+SymbolFile::~SymbolFile() {
+    unmap();
+}
+
+void SymbolFile::unmap() {
+    if (base) ::munmap(base, length);
+    base = nullptr;
+    length = 0;
+}
+
+void SymbolFile::open(const std::string& path) {
+    unmap();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("cannot open symbol file " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE) {
+        ::close(fd);
+        throw std::runtime_error("invalid symbol file " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    base = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        throw std::runtime_error("cannot map symbol file " + path);
+    }
+
+    auto* p = static_cast<const uint8_t*>(base);
+    count = getU32(p + 8);
+    addressCount = getU32(p + 12);
+    stringsSize = getU32(p + 16);
+    uint64_t expected = HEADER_SIZE + uint64_t(count) * ENTRY_SIZE + uint64_t(addressCount) * 4 + stringsSize;
+    if (std::memcmp(p, "P11S", 4) != 0 || getU32(p + 4) != FORMAT_VERSION || expected != length ||
+        addressCount > count) {
+        unmap();
+        throw std::runtime_error("invalid symbol file " + path);
+    }
+
+    entries = p + HEADER_SIZE;
+    addresses = entries + count * ENTRY_SIZE;
+    strings = reinterpret_cast<const char*>(addresses + addressCount * 4);
+
+    // Проверка ссылок один раз, чтобы поиск обходился без проверок
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* e = entries + i * ENTRY_SIZE;
+        if (uint64_t(getU32(e)) + getU16(e + 4) > stringsSize) {
+            unmap();
+            throw std::runtime_error("invalid symbol file " + path);
+        }
+    }
+    for (uint32_t i = 0; i < addressCount; i++) {
+        if (getU32(addresses + 4 * i) >= count) {
+            unmap();
+            throw std::runtime_error("invalid symbol file " + path);
+        }
+    }
+}
+
+SymbolFile::Symbol SymbolFile::at(size_t index) const {
+    const uint8_t* e = entries + index * ENTRY_SIZE;
+    return {std::string_view(strings + getU32(e), getU16(e + 4)), getU16(e + 6),
+            (getU16(e + 8) & CONSTANT) != 0};
+}
+
+bool SymbolFile::find(std::string_view name, Symbol& out) const {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        Symbol sym = at(mid);
+        int cmp = sym.name.compare(name);
+        if (cmp == 0) {
+            out = sym;
+            return true;
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
+
+bool SymbolFile::nearest(uint16_t address, Symbol& out) const {
+    // Первая метка с адресом > address, затем шаг назад
+    size_t lo = 0, hi = addressCount;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (at(getU32(addresses + 4 * mid)).value <= address) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0) return false;
+    out = at(getU32(addresses + 4 * (lo - 1)));
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef PDP11_SYMFILE_HPP
+#define PDP11_SYMFILE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// ========================================================
+// Двоичный файл символов (для mmap и двоичного поиска)
+// ========================================================
+// Формат (числа little-endian, все таблицы выровнены на 4):
+//   заголовок: "P11S" [версия u32][число символов u32]
+//              [число адресов u32][размер строк u32]
+//   символы:   отсортированы по имени, по 12 байт:
+//              [смещение имени u32][длина имени u16][значение u16]
+//              [флаги u16][резерв u16]
+//   адреса:    номера символов-меток (без констант) u32,
+//              отсортированы по значению
+//   строки:    имена подряд, без завершающих нулей
+// Файл читается без разбора: отображение в память и поиск на месте.
+class SymbolFile {
+public:
+    static constexpr uint16_t CONSTANT = 1; // Флаг: .EQU, а не адрес
+
+    struct Symbol {
+        std::string_view name;
+        uint16_t value;
+        bool is_constant;
+    };
+
+    // Запись символов в формате файла; порядок входа не важен
+    static std::string encode(std::vector<Symbol> symbols);
+
+    SymbolFile() = default;
+    SymbolFile(SymbolFile&& other) noexcept;
+    SymbolFile& operator=(SymbolFile&& other) noexcept;
+    SymbolFile(const SymbolFile&) = delete;
+    SymbolFile& operator=(const SymbolFile&) = delete;
+    ~SymbolFile();
+
+    // Бросает std::runtime_error, если файл не открыт или повреждён
+    void open(const std::string& path);
+
+    size_t size() const { return count; }
+    Symbol at(size_t index) const;
+
+    // Поиск по имени (двоичный); false — символа нет
+    bool find(std::string_view name, Symbol& out) const;
+
+    // Ближайшая метка с адресом <= address; false — такой нет
+    bool nearest(uint16_t address, Symbol& out) const;
+
+    // Содержимое файла целиком (для ключа кеша)
+    std::string_view bytes() const { return {static_cast<const char*>(base), length}; }
+
+private:
+    void* base = nullptr;
+    size_t length = 0;
+    uint32_t count = 0;
+    uint32_t addressCount = 0;
+    const uint8_t* entries = nullptr;
+    const uint8_t* addresses = nullptr;
+    const char* strings = nullptr;
+    uint32_t stringsSize = 0;
+
+    void unmap();
+};
+
+#endif // PDP11_SYMFILE_HPP
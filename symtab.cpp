@@ -1,39 +1,220 @@
 #include "symtab.hpp"
+#include "isa.hpp"
+#include <algorithm>
 #include <sstream>
 
+// ========================================================
+// Разделы
+// ========================================================
+void SectionLayout::begin() {
+    list.assign(1, Section{});
+    names.clear();
+    names.emplace("", 0);
+    counters.assign(1, 0);
+    runList.assign(1, Run{0, 0, 0, 0});
+    active = 0;
+    counter = 0;
+    contiguous = true;
+}
+
+void SectionLayout::leave(size_t index) {
+    runList.back().last = index;
+    counters[active] = counter;
+    list[active].size = std::max(list[active].size, counter);
+}
+
+uint16_t SectionLayout::enter(const Directive& dir, size_t index) {
+    leave(index);
+    auto [it, added] = names.emplace(dir.section, static_cast<uint32_t>(list.size()));
+    if (added) {
+        Section section;
+        section.name = dir.section;
+        list.push_back(std::move(section));
+        counters.push_back(0);
+    }
+    Section& section = list[it->second];
+
+    // Атрибуты задаются один раз, до содержимого раздела
+    if (dir.hasAttributes) {
+        if (section.declared && section.attributes != dir.attributes) {
+            throw AssemblyError(dir.range(), "Conflicting attributes for section " + title(dir.section));
+        }
+        if (!section.declared && section.size > 0) {
+            throw AssemblyError(dir.range(), "Attributes of section " + title(dir.section) +
+                                             " must be given before its contents");
+        }
+        section.attributes = dir.attributes;
+        section.declared = true;
+    }
+
+    active = it->second;
+    counter = section.attributes.overlay ? 0 : counters[active];
+    runList.push_back({active, index, index, static_cast<uint16_t>(counter)});
+    return static_cast<uint16_t>(counter);
+}
+
+void SectionLayout::place(size_t statements) {
+    leave(statements);
+
+    uint32_t address = 0;
+    size_t used = 0;
+    bool overlay = false;
+    for (auto& section : list) {
+        uint32_t mask = section.attributes.align - 1u;
+        address = (address + mask) & ~mask;
+        section.base = static_cast<uint16_t>(address);
+        address += section.size;
+        if (section.size > 0) {
+            used++;
+            overlay = overlay || section.attributes.overlay;
+        }
+    }
+    contiguous = used <= 1 && !overlay;
+
+    // Каждый раздел в 64K уже уложился (SymbolTable::advance);
+    // здесь — все разделы вместе
+    if (!contiguous && address > 0x10000) {
+        throw std::runtime_error("Program sections do not fit in 64K: " + std::to_string(address) + " bytes");
+    }
+}
+
+// ========================================================
+// Таблица символов
+// ========================================================
 void SymbolTable::build(const Program& program) {
-    current_addr = 0; // Начинаем с адреса 0
-    
+    begin();
     for (const auto& stmt : program.statements) {
-        processNode(*stmt);
+        add(*stmt);
+    }
+    finish();
+}
+
+void SymbolTable::begin() {
+    current_addr = 0; // Начинаем с адреса 0
+    statement_count = 0;
+    layout.begin();
+}
+
+void SymbolTable::finish() {
+    // Адреса меток — от начала раздела: добавляем базы
+    layout.place(statement_count);
+    if (!layout.single()) {
+        const auto& sections = layout.sections();
+        for (auto& [name, sym] : symbols) {
+            if (!sym.is_constant) sym.value = static_cast<uint16_t>(sym.value + sections[sym.section].base);
+        }
+    }
+
+    // Псевдонимы слитых блоков данных
+    for (const auto& alias : aliases) {
+        auto target = symbols.find(alias.target);
+        if (target == symbols.end()) {
+            throw std::runtime_error("Undefined alias target: " + alias.target);
+        }
+        if (symbols.count(alias.name)) {
+            throw std::runtime_error("Duplicate label: " + alias.name);
+        }
+        auto value = static_cast<uint16_t>(target->second.value + alias.offset);
+        symbols[alias.name] = {value, true, false, target->second.line};
     }
     
     validate(); // Проверяем все ли символы разрешены
 }
 
+void SymbolTable::alias(const std::string& name, const std::string& target, uint16_t offset) {
+    aliases.push_back({name, target, offset});
+}
+
+void SymbolTable::define(const std::string& name, uint16_t value) {
+    symbols[name] = {value, true, true, 0};
+}
+
+void SymbolTable::import(const SymbolFile& file) {
+    imports.push_back(&file);
+}
+
+void SymbolTable::clear() {
+    symbols.clear();
+    aliases.clear();
+    imports.clear();
+}
+
+bool SymbolTable::findImported(const std::string& name, uint16_t& value) const {
+    SymbolFile::Symbol sym;
+    for (const auto* file : imports) {
+        if (file->find(name, sym)) {
+            value = sym.value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Число дополнительных слов операнда (то же правило, что в CodeGenerator)
+static uint16_t extensionWords(const Operand* op) {
+    return op ? isa::extensionWords(op->mode) : 0;
+}
+
+size_t SymbolTable::statementSize(const ASTNode& node, uint16_t address) {
+    if (auto instr = dynamic_cast<const Instruction*>(&node)) {
+        // Слово команды + дополнительные слова операндов
+        return 2 * (1 + extensionWords(instr->src.get()) + extensionWords(instr->dst.get()));
+    }
+    if (auto dir = dynamic_cast<const Directive*>(&node)) {
+        switch (dir->type) {
+            case Directive::Type::EVEN: return address & 1;
+            case Directive::Type::ODD:  return ~address & 1;
+            default:                    return dir->imageSize();
+        }
+    }
+    if (auto label = dynamic_cast<const Label*>(&node)) {
+        return label->statement ? statementSize(*label->statement, address) : 0;
+    }
+    return 0;
+}
+
+std::vector<uint16_t> SymbolTable::sectionAddresses(const Program& program) {
+    std::vector<uint16_t> addresses(program.statements.size());
+    SectionLayout layout;
+    layout.begin();
+    uint16_t address = 0;
+    for (size_t i = 0; i < program.statements.size(); i++) {
+        const ASTNode& node = *program.statements[i];
+        addresses[i] = address;
+        const ASTNode* inner = &node;
+        if (auto label = dynamic_cast<const Label*>(inner)) inner = label->statement.get();
+        auto dir = dynamic_cast<const Directive*>(inner);
+        if (dir && dir->type == Directive::Type::PSECT) {
+            address = layout.enter(*dir, i);
+            continue;
+        }
+        uint16_t next = nextAddress(node, address);
+        layout.advance(static_cast<uint16_t>(next - address));
+        address = next;
+    }
+    return addresses;
+}
+
 void SymbolTable::processNode(const ASTNode& node) {
+    // Адреса байтовые: .BYTE/.ASCII пакуются по байту, команды и
+    // словные данные должны начинаться с чётного адреса
     if (auto instr = dynamic_cast<const Instruction*>(&node)) {
         processInstruction(*instr);
-        // Инструкции PDP-11 занимают 1 или 2 слова
-        current_addr += (instr->dst ? 2 : 1);
+        if (current_addr & 1) {
+            throw AssemblyError(instr->range(), "Instruction at odd address, use .EVEN");
+        }
+        advance(*instr);
     }
     else if (auto dir = dynamic_cast<const Directive*>(&node)) {
+        if (dir->type == Directive::Type::PSECT) {
+            current_addr = layout.enter(*dir, statement_count);
+            return;
+        }
         processDirective(*dir);
-        // Обновляем адрес в зависимости от директивы
-        switch (dir->type) {
-            case Directive::Type::WORD:
-                current_addr += dir->operands.size();
-                break;
-            case Directive::Type::BYTE:
-                current_addr += (dir->operands.size() + 1) / 2;
-                break;
-            case Directive::Type::FILL:
-                current_addr += dir->operands[0]->value;
-                break;
-            // ... другие директивы
-            default:
-                break;
+        if ((current_addr & 1) && dir->isWordData()) {
+            throw AssemblyError(dir->range(), "Word data at odd address, use .EVEN");
         }
+        advance(*dir);
     }
     else if (auto label = dynamic_cast<const Label*>(&node)) {
         processLabel(*label);
@@ -43,6 +224,21 @@ void SymbolTable::processNode(const ASTNode& node) {
     }
 }
 
+// Оператор должен кончаться не дальше 0177777: переноса адреса через
+// 0200000 нет, выход за 64K — ошибка в строке оператора
+void SymbolTable::advance(const ASTNode& node) {
+    size_t bytes = statementSize(node, current_addr);
+    size_t end = layout.offset() + bytes;
+    if (end > isa::ADDRESS_SPACE) {
+        std::ostringstream message;
+        message << "Address overflow: statement at 0" << std::oct << layout.offset()
+                << " ends at 0" << end << ", past 0177777";
+        throw AssemblyError(node.range(), message.str());
+    }
+    layout.advance(static_cast<uint32_t>(bytes));
+    current_addr = static_cast<uint16_t>(end);
+}
+
 void SymbolTable::processInstruction(const Instruction& instr) {
     // Для инструкций нужно обновить current_addr
     // (уже обрабатывается в processNode)
@@ -52,7 +248,7 @@ void SymbolTable::processDirective(const Directive& dir) {
     if (dir.type == Directive::Type::EQU) {
         // Обработка констант вида LABEL .EQU value
         if (dir.operands.size() != 2) {
-            throw std::runtime_error("Invalid .EQU directive");
+            throw AssemblyError(dir.range(), "Invalid .EQU directive");
         }
         
         const auto& label = dynamic_cast<const Operand&>(*dir.operands[0]);
@@ -68,23 +264,33 @@ void SymbolTable::processDirective(const Directive& dir) {
 }
 
 void SymbolTable::processLabel(const Label& label) {
-    if (symbols.count(label.name) && symbols[label.name].is_defined) {
-        throw std::runtime_error("Duplicate label: " + label.name);
+    // Локальные метки n$ разрешает CodeGenerator в пределах блока
+    if (label.local) return;
+
+    uint16_t imported;
+    if ((symbols.count(label.name) && symbols[label.name].is_defined) ||
+        findImported(label.name, imported)) {
+        throw AssemblyError(label.range(), "Duplicate label: " + label.name);
     }
     
     symbols[label.name] = {
         current_addr,
         true,
         false,
-        current_addr
+        current_addr,
+        layout.current()
     };
 }
 
 uint16_t SymbolTable::resolve(const std::string& name) const {
-    if (!symbols.count(name)) {
+    auto it = symbols.find(name);
+    if (it != symbols.end()) return it->second.value;
+
+    uint16_t value;
+    if (!findImported(name, value)) {
         throw std::runtime_error("Undefined symbol: " + name);
     }
-    return symbols.at(name).value;
+    return value;
 }
 
 void SymbolTable::validate() const {
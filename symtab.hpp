@@ -2,10 +2,73 @@
 #define PDP11_SYMTAB_HPP
 
 #include "ast.hpp"
+#include "symfile.hpp"
 #include <unordered_map>
+#include <string>
 #include <vector>
 #include <stdexcept>
 
+// ========================================================
+// Программные разделы (.PSECT/.CSECT)
+// ========================================================
+// У каждого раздела свой счётчик адресов от 0; текст до первой .PSECT
+// попадает в безымянный раздел. После прохода place() назначает базы:
+// разделы подряд в порядке появления, каждый со своим выравниванием.
+// Участок (Run) — операторы одного раздела подряд в Program; по участкам
+// CodeGenerator кодирует разделы независимо друг от друга
+class SectionLayout {
+public:
+    struct Section {
+        std::string name;
+        SectionAttributes attributes;
+        bool declared = false; // Атрибуты уже заданы в .PSECT
+        uint32_t size = 0;     // В байтах; у OVR — длина наибольшего участка
+        uint16_t base = 0;     // Адрес начала (после place)
+    };
+
+    struct Run {
+        uint32_t section;
+        size_t first, last;    // Операторы [first, last)
+        uint16_t start;        // Адрес первого оператора от начала раздела
+    };
+
+    void begin();
+
+    // .PSECT в операторе index; возвращается счётчик раздела, в который перешли
+    uint16_t enter(const Directive& dir, size_t index);
+
+    // Текущий раздел вырос на bytes
+    void advance(uint32_t bytes) { counter += bytes; }
+
+    // Счётчик текущего раздела без переноса через 64K
+    uint32_t offset() const { return counter; }
+
+    // Конец текста (statements операторов): размеры и базы разделов
+    void place(size_t statements);
+
+    uint32_t current() const { return active; }
+    const std::vector<Section>& sections() const { return list; }
+    const std::vector<Run>& runs() const { return runList; }
+
+    // Непустой раздел один, с адреса 0 и без наложений: образ собирается
+    // одним проходом по программе, как без разделов
+    bool single() const { return contiguous; }
+
+    // Имя для сообщений: безымянный раздел — ". BLK.", как в MACRO-11
+    static std::string title(const std::string& name) { return name.empty() ? ". BLK." : name; }
+
+private:
+    std::vector<Section> list;
+    std::vector<Run> runList;
+    std::unordered_map<std::string, uint32_t> names;
+    std::vector<uint32_t> counters; // Байт от начала раздела (без переноса через 64K)
+    uint32_t active = 0;
+    uint32_t counter = 0;           // Счётчик текущего раздела
+    bool contiguous = true;
+
+    void leave(size_t index);
+};
+
 class SymbolTable {
 public:
     // Запись в таблице символов
@@ -14,29 +77,92 @@ public:
         bool is_defined = false; // Определен ли символ
         bool is_constant = false; // Это константа (.EQU)?
         size_t line;            // Строка определения
+        uint32_t section = 0;   // Раздел метки: к value добавляется его база
     };
 
     // Построение таблицы символов
     void build(const Program& program);
+
+    // То же по частям, по мере поступления операторов:
+    // begin(), add() для каждого оператора по порядку, finish()
+    void begin();
+    void add(const ASTNode& statement) {
+        processNode(statement);
+        statement_count++;
+    }
+    void finish();
     
+    // Псевдоним: после раскладки name = адрес target + offset (в байтах).
+    // Задаётся до build (см. DataOptimizer)
+    void alias(const std::string& name, const std::string& target, uint16_t offset);
+
+    // Константа извне (--define): как .EQU до начала текста, сам текст
+    // может её переопределить. Задаётся после clear и до build
+    void define(const std::string& name, uint16_t value);
+
+    // Символы готового образа (например, точки входа ПЗУ): ищутся в
+    // отображённом файле, если в программе символа нет. Файл должен
+    // жить, пока используется таблица
+    void import(const SymbolFile& file);
+
+    // Сброс символов, псевдонимов и импорта перед новой сборкой
+    void clear();
+
     // Разрешение символа
     uint16_t resolve(const std::string& name) const;
+
+    // Метка этой программы: её значение — адрес в образе и меняется
+    // вместе с адресом загрузки (константы и импорт — нет)
+    bool isAddress(const std::string& name) const {
+        auto it = symbols.find(name);
+        return it != symbols.end() && !it->second.is_constant;
+    }
     
     // Проверка на наличие неразрешенных символов
     void validate() const;
     
+    // Байт оператора, начинающегося с address (у .EVEN/.ODD зависит от
+    // чётности адреса)
+    static size_t statementSize(const ASTNode& node, uint16_t address);
+
+    // Адрес сразу за оператором, начинающимся с address (без проверок
+    // и побочных эффектов). Общая раскладка для CodeGenerator и DataOptimizer
+    static uint16_t nextAddress(const ASTNode& node, uint16_t address) {
+        return static_cast<uint16_t>(address + statementSize(node, address));
+    }
+
+    // Адрес каждого оператора от начала его раздела — без символов и
+    // проверок раскладки (DataOptimizer: до раскладки важна чётность)
+    static std::vector<uint16_t> sectionAddresses(const Program& program);
+
+    // Разделы и участки последней раскладки
+    const SectionLayout& sections() const { return layout; }
+
     // Получение текущего адреса (PC)
     uint16_t currentAddress() const { return current_addr; }
     std::unordered_map<std::string, Symbol> symbols;
 
 private:
 
-    uint16_t current_addr = 0; // Текущий адрес в памяти
+    struct Alias {
+        std::string name;
+        std::string target;
+        uint16_t offset;
+    };
+
+    uint16_t current_addr = 0; // Текущий адрес в памяти (в байтах) от начала раздела
+    size_t statement_count = 0; // Операторов раскладки (номер следующего)
+    SectionLayout layout;
+    std::vector<Alias> aliases;
+    std::vector<const SymbolFile*> imports;
+
+    bool findImported(const std::string& name, uint16_t& value) const;
     
     void processNode(const ASTNode& node);
     void processInstruction(const Instruction& instr);
     void processDirective(const Directive& dir);
     void processLabel(const Label& label);
+    void advance(const ASTNode& node);
 };
 
 #endif // PDP11_SYMTAB_HPP
\ No newline at end of file
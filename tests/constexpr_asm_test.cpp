@@ -0,0 +1,83 @@
+// Сверка ассемблера времени компиляции (constexpr_asm.hpp) с Assembler:
+// образы известных фрагментов проверяются static_assert, затем каждый
+// фрагмент собирается Assembler::assemble и сравнивается по словам.
+// Сборка и запуск — tests/run.sh
+#include "../constexpr_asm.hpp"
+#include "../assembler.hpp"
+#include <array>
+#include <cstdio>
+#include <vector>
+
+using namespace pdp11::literals;
+
+namespace {
+
+template <size_t N>
+constexpr bool same(const std::array<uint16_t, N>& image, const std::array<uint16_t, N>& expected) {
+    for (size_t i = 0; i < N; i++) {
+        if (image[i] != expected[i]) return false;
+    }
+    return true;
+}
+
+constexpr auto MODES = "MOV #42,R1\nMOV (R2)+,-(SP)\nADD @#177560,R3\nCLR 4(R5)\nHALT\n"_pdp11;
+static_assert(same(MODES, {012701, 042, 012246, 063703, 0177560, 005065, 4, 0}));
+
+constexpr auto LABELS = "START: MOV MSG,R1\n JSR PC,PUTC\n HALT\nPUTC: RTS PC\nMSG: .WORD START,PUTC\n"_pdp11;
+static_assert(same(LABELS, {016701, 010, 004767, 2, 0, 000207, 0, 012}));
+
+// @метка — относительный косвенный режим 77, смещение до указателя
+constexpr auto DEFERRED = "START: MOV @PTR,R0\n HALT\nPTR: .WORD DATA\nDATA: .WORD 5\n"_pdp11;
+static_assert(same(DEFERRED, {017700, 2, 0, 010, 5}));
+
+constexpr auto NEGATIVE = "MOV #-1,R0\n.WORD -2\n.BYTE 1,-1\n"_pdp11;
+static_assert(same(NEGATIVE, {012700, 0177777, 0177776, 0177401}));
+
+constexpr auto DATA = ".BYTE 1,2,3\n.EVEN\n.ASCIZ \"AB\"\n.BLKB 1\n.WORD 7\n.FILL 2,5\n.BLKW 1\n"_pdp11;
+static_assert(same(DATA, {01001, 3, 041101, 0, 7, 5, 5, 0}));
+
+constexpr auto RADIX = ".EQU K,12\n.RADIX 10\nMOV #12,R0\n.WORD K\n.RADIX 16\n.WORD 1F\n.END\nHALT\n"_pdp11;
+static_assert(same(RADIX, {012700, 12, 012, 037}));
+
+struct Snippet {
+    const char* name;
+    const char* source;
+    const uint16_t* image;
+    size_t size;
+};
+
+template <size_t N>
+constexpr Snippet snippet(const char* name, const char* source, const std::array<uint16_t, N>& image) {
+    return {name, source, image.data(), N};
+}
+
+} // namespace
+
+int main() {
+    const Snippet snippets[] = {
+        snippet("modes", "MOV #42,R1\nMOV (R2)+,-(SP)\nADD @#177560,R3\nCLR 4(R5)\nHALT\n", MODES),
+        snippet("labels", "START: MOV MSG,R1\n JSR PC,PUTC\n HALT\nPUTC: RTS PC\nMSG: .WORD START,PUTC\n", LABELS),
+        snippet("deferred", "START: MOV @PTR,R0\n HALT\nPTR: .WORD DATA\nDATA: .WORD 5\n", DEFERRED),
+        snippet("negative", "MOV #-1,R0\n.WORD -2\n.BYTE 1,-1\n", NEGATIVE),
+        snippet("data", ".BYTE 1,2,3\n.EVEN\n.ASCIZ \"AB\"\n.BLKB 1\n.WORD 7\n.FILL 2,5\n.BLKW 1\n", DATA),
+        snippet("radix", ".EQU K,12\n.RADIX 10\nMOV #12,R0\n.WORD K\n.RADIX 16\n.WORD 1F\n.END\nHALT\n", RADIX),
+    };
+
+    int failed = 0;
+    Assembler assembler;
+    Assembler::Options options;
+    options.collectSymbols = false;
+    std::vector<uint16_t> image;
+    for (const auto& s : snippets) {
+        auto result = assembler.assemble(s.source, options, image);
+        bool ok = result.success && image.size() == s.size;
+        for (size_t i = 0; ok && i < s.size; i++) ok = image[i] == s.image[i];
+        if (!ok) {
+            std::printf("constexpr_asm: %s differs from Assembler::assemble\n", s.name);
+            for (const auto& diag : result.diagnostics) std::printf("  %s\n", DiagnosticEngine::format(diag).c_str());
+            failed++;
+        }
+    }
+    std::printf("constexpr_asm: %zu snippets, %d failed\n", std::size(snippets), failed);
+    return failed ? 1 : 0;
+}
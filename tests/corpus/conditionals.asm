@@ -0,0 +1,27 @@
+; Условное ассемблирование, в том числе условия с меткой в неактивном тексте
+        .EQU    LEVEL, 3
+        .EQU    ZERO, 0
+START:  MOV     R0,R1
+        .IF     EQ ZERO
+        MOV     R1,R2
+        .ENDC
+        .IF     NE LEVEL
+        INC     R0
+        .IFF
+        DEC     R0
+        .IFTF
+        CLR     R3
+        .ENDC
+        .IF     EQ LEVEL
+SKIP:   .IF     EQ ZERO
+        HALT
+        .ENDC
+        HALT
+        .ENDC
+        .IFDF   START
+HERE:   .IF     GT LEVEL
+        MOV     R2,R3
+        .ENDC
+        .ENDC
+        HALT
+        .END
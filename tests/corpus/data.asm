@@ -0,0 +1,22 @@
+; Директивы данных: байты с нечётных адресов, заполнение, .RADIX, .EQU
+        .EQU    SIZE, 4
+        .EQU    MARK, 177777
+START:  MOV     TABLE,R0
+        MOV     SIZE,R1
+        HALT
+TABLE:  .WORD   START, TEXT, 0, MARK
+TEXT:   .ASCIZ  "PDP-11"
+        .BYTE   1, 2, 377
+        .EVEN
+        .ODD
+        .BYTE   7
+        .BLKB   3
+        .EVEN
+        .BLKW   2
+        .FILL   3, 125252
+        .RADIX  10
+        .WORD   100, 255
+        .RADIX
+        .WORD   100
+        .ASCII  "END"
+        .END
@@ -0,0 +1,13 @@
+; run: R0=000005 R1=000007 R2=000005
+; Косвенный относительный @метка (режим 77): по адресу метки лежит адрес
+; операнда. Значения проверяет эмулятор
+START:  MOV     @PTR,R0
+        MOV     #7,R1
+        MOV     R1,@PTR2
+        MOV     @PTR,R2
+        HALT
+PTR:    .WORD   DATA
+PTR2:   .WORD   SLOT
+DATA:   .WORD   5
+SLOT:   .WORD   0
+        .END
@@ -0,0 +1,12 @@
+; Образ ПЗУ: длинные серии заполнения (их P11Z хранит отдельно)
+START:  MOV     TABLE,R0
+        JMP     @#2000
+TABLE:  .WORD   START, END
+        .FILL   400, 177777
+        .BLKW   200
+        .BYTE   1
+        .BLKB   777
+        .EVEN
+        .FILL   1000, 052525
+END:    HALT
+        .END
@@ -0,0 +1,14 @@
+; Локальные метки: одно имя n$ в разных блоках между обычными метками
+COPY:   MOV     #3,R2
+1$:     MOV     (R0)+,(R1)+
+        DEC     R2
+        JMP     2$
+2$:     RTS     PC
+CLEAR:  MOV     #4,R2
+1$:     CLR     (R1)+
+        DEC     R2
+        CMP     R2,#0
+        JMP     @3$
+3$:     .WORD   1$
+        RTS     PC
+        .END
@@ -0,0 +1,34 @@
+; Все режимы адресации в источнике и приёмнике
+START:  MOV     R0,R1
+        MOV     (R1),R2
+        MOV     (R2)+,R3
+        MOV     -(R3),R4
+        MOV     10(R4),R5
+        MOV     #42,R0
+        MOV     @#1000,R1
+        MOV     VALUE,R2
+        MOV     @PTR,R3
+        MOV     R0,(R1)
+        MOV     R0,(R1)+
+        MOV     R0,-(R1)
+        MOV     R0,4(R1)
+        MOV     R0,@#1002
+        MOV     R0,VALUE
+        ADD     #1,R0
+        SUB     VALUE,R0
+        CMP     R0,#100
+        CMP     #100,VALUE
+        CLR     R0
+        COM     (R1)
+        INC     (R1)+
+        DEC     -(R1)
+        NEG     2(R1)
+        JSR     PC,ROUTINE
+        JMP     DONE
+ROUTINE:
+        INC     R0
+        RTS     PC
+DONE:   HALT
+VALUE:  .WORD   123
+PTR:    .WORD   VALUE
+        .END
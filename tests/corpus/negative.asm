@@ -0,0 +1,10 @@
+; run: R0=177777 R1=177776 R2=000001 R3=177401
+; Унарный минус в #n, .WORD и .BYTE: -1 и 177777 — одно и то же слово
+START:  MOV     #-1,R0
+        MOV     MINUS2,R1
+        MOV     R0,R2
+        NEG     R2
+        MOV     BYTES,R3
+        HALT
+MINUS2: .WORD   -2
+BYTES:  .BYTE   1, -1
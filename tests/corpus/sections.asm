@@ -0,0 +1,24 @@
+; Разделы: векторы с адреса 0100, код, константы и наложение (OVR)
+        .PSECT  VECTORS,D,RO,100
+        .WORD   START, 340
+        .PSECT  CODE,I,RO
+START:  MOV     MSG,R1
+        MOV     TABLE,R2
+        JSR     PC,NEXT
+        HALT
+        .PSECT  CONST,D,RO
+MSG:    .ASCIZ  "HELLO"
+        .EVEN
+TABLE:  .WORD   1,2,3,MSG
+        .PSECT  CODE
+NEXT:   MOV     R1,R2
+1$:     INC     R2
+        CMP     R2,1$
+        RTS     PC
+        .PSECT  DATA,D,RW
+BUF:    .BLKW   4
+        .PSECT  OV,D,OVR
+        .WORD   1,2,3
+        .PSECT  OV
+        .WORD   7
+        .END
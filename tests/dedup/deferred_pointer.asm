@@ -0,0 +1,13 @@
+; run: R1=000001 R2=000005 R3=000006
+; Запись через @PTR (режим 77) меняет A: A и B одинаковы только до неё,
+; слить их нельзя, и чтение B должно дать исходное значение
+START: MOV #5,@PTR
+ MOV B,R1
+ MOV @PTR,R2
+ INC @PTR
+ MOV A,R3
+ HALT
+PTR: .WORD A
+A: .WORD 1,2
+B: .WORD 1,2
+ .END
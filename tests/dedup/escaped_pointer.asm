@@ -0,0 +1,9 @@
+; Адрес A уходит в PTR: запись через него не должна попасть в B
+START: MOV PTR,R0
+ MOV #5,(R0)
+ MOV B,R1
+ HALT
+PTR: .WORD A
+A: .WORD 1,2
+B: .WORD 1,2
+ .END
@@ -0,0 +1,9 @@
+; Код читает TBL указателем подряд: T2 без ссылок не удаляется
+START: MOV PTR,R0
+ MOV (R0)+,R1
+ MOV (R0)+,R2
+ HALT
+PTR: .WORD TBL
+TBL: .WORD 1
+T2: .WORD 2
+ .END
@@ -0,0 +1,5 @@
+; expect: address_wrap.asm:5:9: error: Address overflow: statement at 0200000 ends at 0200002, past 0177777
+; Каждый блок помещается, но вместе они выходят за 0177777
+        MOV     R0,R1
+        .BLKW   77777
+        HALT
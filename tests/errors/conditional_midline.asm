@@ -0,0 +1,4 @@
+; expect: conditional_midline.asm:3:23: error: .IF must start a statement
+; Условие — отдельный оператор: в середине строки не распознаётся
+        MOV     R0,R1 .IF EQ 0
+        HALT
@@ -0,0 +1,5 @@
+; expect: fill_count.asm:4:9: error: Block of 4294967294 bytes does not fit in 64K address space
+; Счёт .FILL больше адресного пространства: ошибка до выделения памяти
+        MOV     R0,R1
+        .FILL   17777777777,1
+        HALT
@@ -0,0 +1,7 @@
+; expect: skipped_label.asm:8:1: error: Missing .ENDC for .IF at line 4
+; Условие с меткой в неактивном тексте — вложенный блок, как и в активном:
+; единственный .ENDC закрывает его, а не внешний блок
+        .IF     EQ 1
+X:      .IF     EQ 0
+        .ENDC
+        HALT
@@ -0,0 +1,123 @@
+#!/bin/sh
+# Тесты ассемблера: сборка и все проверки подряд.
+#   tests/run.sh [каталог сборки]   (по умолчанию _test_build)
+# Код возврата — число проваленных проверок
+set -u
+root=$(cd "$(dirname "$0")/.." && pwd)
+build=${1:-$root/_test_build}
+CXX=${CXX:-g++}
+mkdir -p "$build"
+
+library=""
+for source in "$root"/*.cpp; do
+    [ "$(basename "$source")" = main.cpp ] || library="$library $source"
+done
+
+echo "Building..."
+$CXX -std=c++17 -O2 -Wall -pthread -o "$build/asm" "$root"/*.cpp || exit 1
+asm="$build/asm"
+
+failed=0
+check() {
+    name=$1
+    shift
+    if "$@" >"$build/$name.log" 2>&1; then
+        echo "PASS $name"
+    else
+        echo "FAIL $name (log: $build/$name.log)"
+        failed=$((failed + 1))
+    fi
+}
+
+# 1. Ассемблер времени компиляции против Assembler::assemble (C++20)
+constexpr_asm() {
+    $CXX -std=c++20 -O1 -Wall -pthread -o "$build/constexpr_asm_test" \
+        "$root/tests/constexpr_asm_test.cpp" $library && "$build/constexpr_asm_test"
+}
+check constexpr_asm constexpr_asm
+
+# 2. --dedup не меняет поведение программы: регистры после --run те же
+registers() {
+    "$asm" "$1" "$build/image.bin" $2 >/dev/null && "$asm" --run "$build/image.bin" 2>&1 | grep '^R0='
+}
+dedup() {
+    plain=$(registers "$1" "") && merged=$(registers "$1" --dedup) || return 1
+    echo "plain:  $plain"
+    echo "dedup:  $merged"
+    [ "$plain" = "$merged" ] || return 1
+    # Первая строка "; run: <регистры>" — ожидаемые значения
+    expected=$(sed -n '1s/^; run: //p' "$1")
+    case $merged in
+        *"$expected"*) return 0 ;;
+        *) return 1 ;;
+    esac
+}
+for source in "$root"/tests/dedup/*.asm; do
+    check "dedup_$(basename "$source" .asm)" dedup "$source"
+done
+
+# 3. Ошибочные программы: сборка отвергается с ожидаемым сообщением
+# (первая строка файла — "; expect: <текст>")
+expect_error() {
+    expected=$(sed -n '1s/^; expect: //p' "$1")
+    # Сообщение с путём как в командной строке: из каталога файла
+    output=$(cd "$(dirname "$1")" && "$asm" "$(basename "$1")" "$build/image.bin" 2>&1) && return 1
+    echo "$output"
+    case $output in
+        *"$expected"*) return 0 ;;
+        *) return 1 ;;
+    esac
+}
+for source in "$root"/tests/errors/*.asm; do
+    check "error_$(basename "$source" .asm)" expect_error "$source"
+done
+
+# 4. Корпус (и примеры из корня): дизассемблирование собирается в тот же
+# образ, P11Z распаковывается в тот же образ, --pipeline даёт тот же образ
+corpus="$root/tests/corpus/*.asm $root/input.asm $root/input2.asm"
+compressed() {
+    "$asm" "$1" "$build/image.bin" >/dev/null &&
+        "$asm" "$1" "$build/image.p11z" --compress >/dev/null &&
+        "$asm" --decompress "$build/image.p11z" "$build/unpacked.bin" &&
+        cmp "$build/image.bin" "$build/unpacked.bin"
+}
+pipelined() {
+    "$asm" "$1" "$build/image.bin" >/dev/null &&
+        "$asm" "$1" "$build/pipelined.bin" --pipeline >/dev/null &&
+        cmp "$build/image.bin" "$build/pipelined.bin"
+}
+# Первая строка "; run: <регистры>" — образ ещё и выполняется в эмуляторе
+executed() {
+    expected=$(sed -n '1s/^; run: //p' "$1")
+    "$asm" "$1" "$build/image.bin" >/dev/null || return 1
+    output=$("$asm" --run "$build/image.bin" 2>&1)
+    echo "$output"
+    case $output in
+        *"$expected"*) return 0 ;;
+        *) return 1 ;;
+    esac
+}
+for source in $corpus; do
+    base=$(basename "$source" .asm)
+    check "verify_$base" "$asm" --verify "$source"
+    check "p11z_$base" compressed "$source"
+    check "pipeline_$base" pipelined "$source"
+    if head -n 1 "$source" | grep -q '^; run: '; then
+        check "run_$base" executed "$source"
+    fi
+done
+
+# 5. --batch длиннее RLIMIT_NOFILE: файлы открываются частями
+batch_fd_limit() {
+    rm -rf "$build/batch" && mkdir -p "$build/batch/out" || return 1
+    i=0
+    while [ $i -lt 200 ]; do
+        printf 'START: MOV #%o,R0\n HALT\n' $i >"$build/batch/f$i.asm"
+        i=$((i + 1))
+    done
+    (ulimit -n 64 && "$asm" --batch="$build/batch/out" "$build"/batch/f*.asm) || return 1
+    [ "$(ls "$build/batch/out" | wc -l)" -eq 200 ]
+}
+check batch_fd_limit batch_fd_limit
+
+exit $failed
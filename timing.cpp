@@ -0,0 +1,170 @@
+#include "timing.hpp"
+#include <iomanip>
+
+// ========================================================
+// 1. Таблицы моделей (нс)
+// ========================================================
+static const TimingModel MODELS[] = {
+    {
+        "11/20", 280,
+        2300, 2300, 2300, 1200, 2900, 3500, 1800,
+        {0, 1500, 1500, 2700, 1500, 2700, 2700, 3900},
+        {0, 1400, 1400, 2600, 1400, 2600, 2600, 3800},
+        {0, 1400, 1400, 2600, 1400, 2600, 2600, 3800},
+        {0, 1200, 1500, 2400, 1500, 2400, 2400, 3600},
+    },
+    {
+        "11/34", 180,
+        2070, 2070, 1830, 1070, 2870, 2790, 1800,
+        {0, 1470, 1470, 2730, 1730, 2970, 2930, 4190},
+        {0, 1730, 1730, 2990, 1990, 3250, 3190, 4450},
+        {0, 1270, 1270, 2530, 1530, 2770, 2730, 3990},
+        {0, 720, 1230, 1330, 1230, 1330, 1390, 2650},
+    },
+    {
+        "11/40", 140,
+        900, 990, 990, 920, 2450, 2420, 1800,
+        {0, 780, 840, 1740, 840, 1740, 1460, 2370},
+        {0, 1160, 1220, 2120, 1220, 2120, 1840, 2750},
+        {0, 960, 1020, 1920, 1020, 1920, 1640, 2550},
+        {0, 300, 600, 900, 600, 900, 910, 1820},
+    },
+};
+
+static const char* const MNEMONICS[13] = {
+    "MOV", "CMP", "ADD", "SUB", "JSR", "RTS",
+    "HALT", "CLR", "COM", "INC", "DEC", "NEG", "JMP"
+};
+
+static const char* const MODE_NAMES[8] = {
+    "register      Rn",
+    "deferred      (Rn)",
+    "autoincrement (Rn)+",
+    "autoinc def.  @(Rn)+",
+    "autodecrement -(Rn)",
+    "autodec def.  @-(Rn)",
+    "index         X(Rn)",
+    "index def.    @X(Rn)"
+};
+
+const TimingModel* TimingModel::find(const std::string& name) {
+    std::string key = name.rfind("PDP-", 0) == 0 ? name.substr(4) : name;
+    for (const auto& model : MODELS) {
+        if (key == model.name) return &model;
+    }
+    return nullptr;
+}
+
+std::string TimingModel::knownModels() {
+    std::string names;
+    for (const auto& model : MODELS) {
+        if (!names.empty()) names += ", ";
+        names += model.name;
+    }
+    return names;
+}
+
+unsigned TimingModel::instructionTime(const EncodedInstruction& instr) const {
+    unsigned src = instr.srcMode == EncodedInstruction::NO_OPERAND ? 0 : srcTime[instr.srcMode >> 3];
+    unsigned dstMode = instr.dstMode == EncodedInstruction::NO_OPERAND ? 0 : instr.dstMode >> 3;
+
+    switch (instr.type) {
+        case Instruction::Type::MOV:
+            return movBasic + src + movDstTime[dstMode];
+        case Instruction::Type::CMP:
+        case Instruction::Type::ADD:
+        case Instruction::Type::SUB:
+            return doubleBasic + src + dstTime[dstMode];
+        case Instruction::Type::JMP:
+            return jmpBasic + jmpTime[dstMode];
+        case Instruction::Type::JSR:
+            return jsrBasic + jmpTime[dstMode];
+        case Instruction::Type::RTS:
+            return rtsBasic;
+        case Instruction::Type::HALT:
+            return haltBasic;
+        default:
+            return singleBasic + dstTime[dstMode];
+    }
+}
+
+// ========================================================
+// 2. Отчёт
+// ========================================================
+TimingReport::TimingReport(const TimingModel& model, const std::vector<EncodedInstruction>& instructions)
+    : model(model), instructions(instructions) {
+    times.reserve(instructions.size());
+
+    for (const auto& instr : instructions) {
+        unsigned ns = model.instructionTime(instr);
+        times.push_back(ns);
+        total += ns;
+
+        // Блоки идут подряд: новая метка открывает новый блок
+        if (blocks.empty() || blocks.back().name != instr.block) {
+            blocks.push_back({instr.block, 0, 0});
+        }
+        blocks.back().count++;
+        blocks.back().ns += ns;
+
+        opcodeCounts[static_cast<size_t>(instr.type)]++;
+        if (instr.srcMode != EncodedInstruction::NO_OPERAND) modeCounts[instr.srcMode >> 3]++;
+        if (instr.dstMode != EncodedInstruction::NO_OPERAND) modeCounts[instr.dstMode >> 3]++;
+    }
+}
+
+static std::string modeText(uint8_t mode) {
+    if (mode == EncodedInstruction::NO_OPERAND) return "  ";
+    char text[3] = {static_cast<char>('0' + (mode >> 3)), static_cast<char>('0' + (mode & 7)), 0};
+    return text;
+}
+
+void TimingReport::print(std::ostream& out) const {
+    auto cycles = [&](uint64_t ns) { return (ns + model.cycleNs / 2) / model.cycleNs; };
+    auto flags = out.flags();
+
+    out << "Timing estimate for PDP-" << model.name << "\n\n";
+    out << "Address  Instr  SS DD  Words   Time(ns)  Cycles\n";
+    for (size_t i = 0; i < instructions.size(); i++) {
+        const auto& instr = instructions[i];
+        out << std::oct << std::setfill('0') << std::setw(6) << instr.address << std::dec << std::setfill(' ')
+            << "   " << std::left << std::setw(5) << MNEMONICS[static_cast<size_t>(instr.type)] << std::right
+            << "  " << modeText(instr.srcMode) << " " << modeText(instr.dstMode)
+            << "  " << std::setw(5) << static_cast<unsigned>(instr.words)
+            << "  " << std::setw(9) << times[i]
+            << "  " << std::setw(6) << cycles(times[i]) << "\n";
+    }
+
+    out << "\nBlocks:\n";
+    for (const auto& block : blocks) {
+        out << "  " << std::left << std::setw(16) << (block.name.empty() ? "<start>" : block.name) << std::right
+            << std::setw(6) << block.count << " instr  "
+            << std::setw(10) << block.ns << " ns  "
+            << std::setw(8) << cycles(block.ns) << " cycles\n";
+    }
+    out << "  " << std::left << std::setw(16) << "TOTAL" << std::right
+        << std::setw(6) << instructions.size() << " instr  "
+        << std::setw(10) << total << " ns  "
+        << std::setw(8) << cycles(total) << " cycles\n";
+
+    size_t operands = 0;
+    for (auto count : modeCounts) operands += count;
+
+    out << "\nOpcode histogram:\n" << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < 13; i++) {
+        if (!opcodeCounts[i]) continue;
+        out << "  " << std::left << std::setw(6) << MNEMONICS[i] << std::right
+            << std::setw(8) << opcodeCounts[i]
+            << std::setw(7) << 100.0 * opcodeCounts[i] / instructions.size() << "%\n";
+    }
+
+    out << "\nAddressing mode histogram (src + dst):\n";
+    for (size_t i = 0; i < 8; i++) {
+        if (!modeCounts[i]) continue;
+        out << "  " << i << " " << std::left << std::setw(22) << MODE_NAMES[i] << std::right
+            << std::setw(8) << modeCounts[i]
+            << std::setw(7) << 100.0 * modeCounts[i] / operands << "%\n";
+    }
+
+    out.flags(flags);
+}
@@ -0,0 +1,65 @@
+#ifndef PDP11_TIMING_HPP
+#define PDP11_TIMING_HPP
+
+#include "codegen.hpp"
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// ========================================================
+// Статическая оценка времени выполнения по таблицам DEC
+// ========================================================
+// Время команды = базовое время + время выборки src + время dst.
+// Значения в наносекундах, по таблицам Processor Handbook
+// (PDP-11/20, 11/34, 11/40), без учёта памяти MOS/кеша и DMA.
+struct TimingModel {
+    const char* name;
+    unsigned cycleNs;            // Длительность микроцикла процессора
+
+    unsigned movBasic;           // MOV
+    unsigned doubleBasic;        // CMP, ADD, SUB
+    unsigned singleBasic;        // CLR, COM, INC, DEC, NEG
+    unsigned jmpBasic;
+    unsigned jsrBasic;
+    unsigned rtsBasic;
+    unsigned haltBasic;
+
+    unsigned srcTime[8];         // Выборка источника, по режиму 0-7
+    unsigned dstTime[8];         // Приёмник с чтением (чтение-модификация-запись)
+    unsigned movDstTime[8];      // Приёмник MOV (только запись)
+    unsigned jmpTime[8];         // Вычисление адреса перехода JMP/JSR
+
+    // Модель по имени ("11/20", "11/34", "11/40"); nullptr, если неизвестна
+    static const TimingModel* find(const std::string& name);
+    static std::string knownModels();
+
+    unsigned instructionTime(const EncodedInstruction& instr) const;
+};
+
+// Отчёт: аннотированный листинг, суммы по блокам, гистограммы
+class TimingReport {
+public:
+    TimingReport(const TimingModel& model, const std::vector<EncodedInstruction>& instructions);
+
+    void print(std::ostream& out) const;
+
+    uint64_t totalNs() const { return total; }
+
+private:
+    struct Block {
+        std::string name;
+        size_t count = 0;
+        uint64_t ns = 0;
+    };
+
+    const TimingModel& model;
+    const std::vector<EncodedInstruction>& instructions;
+    std::vector<unsigned> times;
+    std::vector<Block> blocks;
+    size_t opcodeCounts[13] = {};
+    size_t modeCounts[8] = {};
+    uint64_t total = 0;
+};
+
+#endif // PDP11_TIMING_HPP